@@ -4,34 +4,18 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+# core - Qt free parsing and analysis library
+# gui  - GPX_Analizator desktop application
+# cli  - gpx_batch command line analyzer for servers without display
+# bench - gpx_bench synthetic track generator and benchmarks
 
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+TEMPLATE = subdirs
 
-TARGET = GPX_Analizator
-TEMPLATE = app
+SUBDIRS = core \
+			gui \
+			cli \
+			bench
 
-# The following define makes your compiler emit warnings if you use
-# any feature of Qt which as been marked as deprecated (the exact warnings
-# depend on your compiler). Please consult the documentation of the
-# deprecated API in order to know how to port your code away from it.
-DEFINES += QT_DEPRECATED_WARNINGS
-
-# You can also make your code fail to compile if you use deprecated APIs.
-# In order to do so, uncomment the following line.
-# You can also select to disable deprecated APIs only up to a certain version of Qt.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
-
-
-SOURCES += main.cpp\
-			MGpxTools.cpp \
-			GraphWidget.cpp \
-			TrackInfo.cpp \
-    GPXAnalizator.cpp
-
-HEADERS  += MGpxTools.h \
-			GraphWidget.h \
-			TrackInfo.h \
-    GPXAnalizator.h
-
-FORMS    += mainwindow.ui
+gui.depends = core
+cli.depends = core
+bench.depends = core
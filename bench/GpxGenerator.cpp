@@ -0,0 +1,113 @@
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <algorithm>
+#include "GpxGenerator.h"
+
+time_t const START_TIME = 1494374400; // 2017-05-10T00:00:00Z
+time_t const GAP_DURATION = 600;      // longer than gpx::DEFAULT_GAP_TIME
+size_t const FLUSH_SIZE = 1 << 20;    // bytes collected before a write to the stream
+double const METERS_PER_DEGREE = 111320;
+double const DEGREES_TO_RADIANS = 3.14159265358979323846 / 180;
+
+//-------------------------------------------------------------------------
+/// splitmix64, unlike std distributions it gives the same sequence with every standard library.
+class Random
+{
+public:
+	explicit Random( uint64_t iSeed ) : m_state( iSeed ) {}
+
+	uint64_t Next()
+	{
+		uint64_t z = ( m_state += 0x9e3779b97f4a7c15ull );
+		z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ull;
+		z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebull;
+		return z ^ ( z >> 31 );
+	}
+	/// Uniform in [ 0, 1 ).
+	double Uniform() { return double( Next() >> 11 ) * ( 1.0 / 9007199254740992.0 ); }
+	bool Chance( double iRate ) { return iRate > 0 && Uniform() < iRate; }
+
+private:
+	uint64_t m_state;
+};
+
+//-------------------------------------------------------------------------
+/// "YYYY-MM-DDThh:mm:ssZ" of a UTC time, gmtime isn't used as it's neither thread safe nor portable.
+void FormatTime( time_t iTime, char * oBuffer, size_t iSize )
+{
+	long long const days = iTime >= 0 ? iTime / 86400 : ( iTime - 86399 ) / 86400;
+	long long const seconds = iTime - days * 86400;
+	// civil from days, http://howardhinnant.github.io/date_algorithms.html
+	long long const z = days + 719468;
+	long long const era = ( z >= 0 ? z : z - 146096 ) / 146097;
+	long long const doe = z - era * 146097;
+	long long const yoe = ( doe - doe / 1460 + doe / 36524 - doe / 146096 ) / 365;
+	long long const doy = doe - ( 365 * yoe + yoe / 4 - yoe / 100 );
+	long long const mp = ( 5 * doy + 2 ) / 153;
+	long long const day = doy - ( 153 * mp + 2 ) / 5 + 1;
+	long long const month = mp < 10 ? mp + 3 : mp - 9;
+	long long const year = yoe + era * 400 + ( month <= 2 );
+	snprintf( oBuffer, iSize, "%04lld-%02lld-%02lldT%02lld:%02lld:%02lldZ", year, month, day,
+			seconds / 3600, seconds / 60 % 60, seconds % 60 );
+}
+
+//-------------------------------------------------------------------------
+void GenerateGpx( GeneratorOptions const & iOptions, std::ostream & ioStream )
+{
+	Random random( iOptions.seed );
+	std::string out;
+	out.reserve( FLUSH_SIZE + 1024 );
+	out += "<?xml version=\"1.0\"?>\n<gpx version=\"1.0\" creator=\"gpx_bench\" xmlns=\"http://www.topografix.com/GPX/1/0\">\n"
+		"  <trk><name>Synthetic</name>\n    <trkseg>\n";
+
+	double lat = 55.75;
+	double lon = 37.62;
+	double speed = 0;   // km/h
+	double heading = 0; // degrees
+	time_t time = START_TIME;
+	char buffer[ 512 ];
+	char timeText[ 32 ];
+
+	for( size_t i = 0; i < iOptions.pointCount; ++i ) {
+		// drive: speed drifts to a random target, a stop now and then
+		double const target = random.Chance( 0.002 ) ? 0 : 20 + 110 * random.Uniform();
+		speed = std::max( 0.0, speed + ( target - speed ) * 0.05 + ( random.Uniform() - 0.5 ) * 4 );
+		heading = fmod( heading + ( random.Uniform() - 0.5 ) * 20 + 360, 360 );
+		double const meters = speed / 3.6 * double( iOptions.samplePeriod );
+		lat += meters * cos( heading * DEGREES_TO_RADIANS ) / METERS_PER_DEGREE;
+		lon += meters * sin( heading * DEGREES_TO_RADIANS ) / ( METERS_PER_DEGREE * cos( lat * DEGREES_TO_RADIANS ) );
+		time += iOptions.samplePeriod;
+		if( random.Chance( iOptions.gapRate ) )
+			time += GAP_DURATION;
+
+		time_t const writtenTime = random.Chance( iOptions.disorderRate ) ? time - 2 * iOptions.samplePeriod - 1 : time;
+		FormatTime( writtenTime, timeText, sizeof( timeText ) );
+
+		if( random.Chance( iOptions.malformedRate ) ) {
+			switch( random.Next() % 4 ) {
+			case 0: snprintf( buffer, sizeof( buffer ), "      <trkpt lon=\"%.6f\"><time>%s</time></trkpt>\n", lon, timeText ); break;
+			case 1: snprintf( buffer, sizeof( buffer ), "      <trkpt lat=\"%.6f\" lon=\"x%.6f\"><time>%s</time></trkpt>\n", lat, lon, timeText ); break;
+			case 2: snprintf( buffer, sizeof( buffer ), "      <trkpt lat=\"%.6f\" lon=\"%.6f\"><hdop>1</hdop></trkpt>\n", lat, lon ); break;
+			default: snprintf( buffer, sizeof( buffer ), "      <trkpt lat=\"%.6f\" lon=\"%.6f\"><time>2017-13-45T99:00:00Z</time></trkpt>\n", lat, lon ); break;
+			}
+		} else if( iOptions.extraTags ) {
+			snprintf( buffer, sizeof( buffer ), "      <trkpt lat=\"%.6f\" lon=\"%.6f\"><ele>%.1f</ele><time>%s</time>"
+				"<course>%.1f</course><speed>%.2f</speed><sat>%u</sat><hdop>%.1f</hdop>"
+				"<desc>mcc: 250, mnc: 1, lac: %u, cid: %u, ss: -%u, ta: 0</desc></trkpt>\n",
+				lat, lon, 150 + 50 * random.Uniform(), timeText, heading, speed / 3.6, unsigned( 4 + random.Next() % 9 ),
+				0.5 + 2 * random.Uniform(), unsigned( random.Next() % 65536 ), unsigned( random.Next() % 65536 ), unsigned( 50 + random.Next() % 60 ) );
+		} else {
+			snprintf( buffer, sizeof( buffer ), "      <trkpt lat=\"%.6f\" lon=\"%.6f\"><time>%s</time></trkpt>\n", lat, lon, timeText );
+		}
+		out += buffer;
+
+		if( out.size() >= FLUSH_SIZE ) {
+			ioStream.write( out.data(), std::streamsize( out.size() ) );
+			out.clear();
+		}
+	}
+
+	out += "    </trkseg>\n  </trk>\n</gpx>\n";
+	ioStream.write( out.data(), std::streamsize( out.size() ) );
+}
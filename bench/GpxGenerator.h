@@ -0,0 +1,25 @@
+#pragma once
+
+#include <time.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <ostream>
+
+/// Parameters of a synthetic track.
+struct GeneratorOptions
+{
+	size_t   pointCount = 100000;
+	uint64_t seed = 1;
+	time_t   samplePeriod = 1;     /// seconds between positions
+	double   gapRate = 0.001;      /// share of positions followed by a pause longer than gpx::DEFAULT_GAP_TIME
+	double   disorderRate = 0;     /// share of positions written with a time earlier than the previous one
+	double   malformedRate = 0;    /// share of positions with broken coordinates or time
+	bool     extraTags = false;    /// ele, speed, course, hdop, sat and desc in every position
+};
+
+/**
+ * Writes a synthetic GPX track of a vehicle: speed and heading drift randomly, stops and
+ * gaps interrupt driving. The output depends on the options only (random numbers don't come from
+ * the standard library), so benchmark inputs are reproducible across runs, machines and commits.
+ */
+void GenerateGpx( GeneratorOptions const & iOptions, std::ostream & ioStream );
@@ -0,0 +1,27 @@
+# gpx_bench - synthetic GPX generator and benchmarks of every processing stage.
+# The graph rendering is measured when Qt widgets are available.
+
+include(../common.pri)
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = gpx_bench
+TEMPLATE = app
+
+include(../core/core.pri)
+
+SOURCES += main.cpp \
+			GpxGenerator.cpp
+
+HEADERS += GpxGenerator.h
+
+qtHaveModule(widgets) {
+	QT += widgets
+	DEFINES += GPX_BENCH_RENDER
+	INCLUDEPATH += ../gui
+	SOURCES += ../gui/GraphWidget.cpp
+	HEADERS += ../gui/GraphWidget.h
+} else {
+	CONFIG -= qt
+}
@@ -0,0 +1,351 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <array>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <zlib.h>
+#include "GpxGenerator.h"
+#include "MGpxTools.h"
+#include "Track.h"
+#include "Geodesy.h"
+#include "TrackCache.h"
+#include "TrackInfo.h"
+#include "TrackSimplify.h"
+#include "SpeedIndex.h"
+#include "CompressedTrack.h"
+
+#ifdef GPX_BENCH_RENDER
+#include <QApplication>
+#include "GraphWidget.h"
+#endif
+
+namespace
+{
+	struct Options
+	{
+		GeneratorOptions generator;
+		std::string      file = "gpx_bench.gpx";
+		unsigned         repeat = 3;
+		float            speedLimit = 105;
+		bool             json = false;
+		bool             keep = false;
+	};
+
+	/// Memory of the parsed track as it is and compressed.
+	struct MemoryUsage
+	{
+		size_t track = 0;
+		size_t compressed = 0;
+	};
+
+	/// Distances of a geodesic policy against gpx::Vincenty.
+	struct GeodesicError
+	{
+		std::string name;
+		double      trackRelative = 0;   /// of the whole track length
+		double      longMaxRelative = 0; /// the largest of long segments
+	};
+
+	/// Two positions: longitude, latitude, longitude, latitude.
+	typedef std::vector< std::array< double, 4 > > TSegments;
+
+	/// Timings of one benchmark stage.
+	struct Stage
+	{
+		std::string           name;
+		size_t                bytes = 0;  /// input bytes of one run, 0 when the stage doesn't read the file
+		size_t                items = 0;  /// points (or queries) processed by one run
+		std::vector< double > seconds;
+
+		double Best() const { return *std::min_element( seconds.begin(), seconds.end() ); }
+		double Median() const
+		{
+			std::vector< double > sorted = seconds;
+			std::sort( sorted.begin(), sorted.end() );
+			return sorted[ sorted.size() / 2 ];
+		}
+	};
+
+	//-------------------------------------------------------------------------
+	void PrintUsage()
+	{
+		std::cerr << "Usage: gpx_bench [--points <n>] [--seed <n>] [--period <s>] [--gaps <rate>] [--disorder <rate>]\n"
+			"                 [--malformed <rate>] [--extra-tags] [--repeat <n>] [--file <path>] [--keep] [--format text|json]\n"
+			"Generates a synthetic GPX track and measures every processing stage on it.\n"
+			"Rates are shares of positions, 0..1. The track file is removed unless --keep is given.\n";
+	}
+
+	//-------------------------------------------------------------------------
+	bool ParseArguments( int argc, char * argv[], Options & oOptions )
+	{
+		GeneratorOptions & generator = oOptions.generator;
+		for( int i = 1; i < argc; ++i ) {
+			std::string const arg = argv[ i ];
+			bool const hasValue = i + 1 < argc;
+			if( arg == "--points" && hasValue ) {
+				generator.pointCount = size_t( std::strtoull( argv[ ++i ], nullptr, 10 ) );
+			} else if( arg == "--seed" && hasValue ) {
+				generator.seed = std::strtoull( argv[ ++i ], nullptr, 10 );
+			} else if( arg == "--period" && hasValue ) {
+				generator.samplePeriod = std::max( 1l, std::strtol( argv[ ++i ], nullptr, 10 ) );
+			} else if( arg == "--gaps" && hasValue ) {
+				generator.gapRate = std::strtod( argv[ ++i ], nullptr );
+			} else if( arg == "--disorder" && hasValue ) {
+				generator.disorderRate = std::strtod( argv[ ++i ], nullptr );
+			} else if( arg == "--malformed" && hasValue ) {
+				generator.malformedRate = std::strtod( argv[ ++i ], nullptr );
+			} else if( arg == "--extra-tags" ) {
+				generator.extraTags = true;
+			} else if( arg == "--repeat" && hasValue ) {
+				oOptions.repeat = std::max( 1u, unsigned( std::strtoul( argv[ ++i ], nullptr, 10 ) ) );
+			} else if( arg == "--file" && hasValue ) {
+				oOptions.file = argv[ ++i ];
+			} else if( arg == "--keep" ) {
+				oOptions.keep = true;
+			} else if( arg == "--format" && hasValue ) {
+				std::string const format = argv[ ++i ];
+				if( format != "text" && format != "json" )
+					return false;
+				oOptions.json = format == "json";
+			} else {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+	/// Runs @a iRun @a iRepeat times, the result of a run is consumed so the work can't be optimized out.
+	Stage Measure( std::string const & iName, unsigned iRepeat, size_t iBytes, size_t iItems, std::function< size_t() > const & iRun )
+	{
+		Stage stage;
+		stage.name = iName;
+		stage.bytes = iBytes;
+		stage.items = iItems;
+		static volatile size_t sink = 0;
+		for( unsigned i = 0; i < iRepeat; ++i ) {
+			auto const start = std::chrono::steady_clock::now();
+			sink = sink + iRun();
+			stage.seconds.push_back( std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count() );
+		}
+		return stage;
+	}
+
+	//-------------------------------------------------------------------------
+	/// Length of the track in meters by @a TGeodesic.
+	template< typename TGeodesic >
+	double TrackMeters( Track const & iTrack )
+	{
+		double result = 0;
+		for( size_t i = 0; i + 1 < iTrack.size(); ++i )
+			result += TGeodesic::Meters( iTrack.x[ i ], iTrack.y[ i ], iTrack.x[ i + 1 ], iTrack.y[ i + 1 ] );
+		return result;
+	}
+
+	//-------------------------------------------------------------------------
+	/// Segments of 10..2000 km at latitudes up to 80 degrees, like gaps of a track after a flight or a ferry.
+	TSegments LongSegments( uint64_t iSeed, size_t iCount )
+	{
+		std::mt19937_64 random( iSeed );
+		std::uniform_real_distribution< double > longitude( -180, 180 ), latitude( -80, 80 ), course( 0, 2 * PI ), length( 10e3, 2000e3 );
+		TSegments result( iCount );
+		for( auto & segment: result ) {
+			// a step on the sphere is enough for a spread of directions and lengths, the lengths are measured later
+			double const x = longitude( random ), y = latitude( random ), angle = course( random );
+			double const degrees = length( random ) / gpx::EARTH_RADIUS / PI_FACTOR;
+			double const nextY = std::max( -89.0, std::min( 89.0, y + degrees * ::cos( angle ) ) );
+			segment = { x, y, x + degrees * ::sin( angle ) / CosLatitude( ( y + nextY ) / 2 ), nextY };
+		}
+		return result;
+	}
+
+	//-------------------------------------------------------------------------
+	template< typename TGeodesic >
+	GeodesicError MeasureError( std::string const & iName, Track const & iTrack, TSegments const & iLong )
+	{
+		GeodesicError result;
+		result.name = iName;
+		double const exact = TrackMeters< gpx::Vincenty >( iTrack );
+		result.trackRelative = exact > 0 ? ::fabs( TrackMeters< TGeodesic >( iTrack ) - exact ) / exact : 0;
+		for( auto const & s: iLong ) {
+			double const meters = gpx::Vincenty::Meters( s[ 0 ], s[ 1 ], s[ 2 ], s[ 3 ] );
+			result.longMaxRelative = std::max( result.longMaxRelative, ::fabs( TGeodesic::Meters( s[ 0 ], s[ 1 ], s[ 2 ], s[ 3 ] ) - meters ) / meters );
+		}
+		return result;
+	}
+
+	//-------------------------------------------------------------------------
+	/// Gzip copy of @a iFrom, as archives keep tracks.
+	bool WriteGzip( std::string const & iFrom, std::string const & iTo )
+	{
+		std::ifstream input( iFrom, std::ios::binary );
+		gzFile const output = ::gzopen( iTo.c_str(), "wb" );
+		if( !input || output == nullptr )
+			return false;
+		std::vector< char > buffer( 1 << 20 );
+		bool ok = true;
+		while( ok && input.read( buffer.data(), std::streamsize( buffer.size() ) ).gcount() > 0 )
+			ok = ::gzwrite( output, buffer.data(), unsigned( input.gcount() ) ) == int( input.gcount() );
+		return ::gzclose( output ) == Z_OK && ok;
+	}
+
+	//-------------------------------------------------------------------------
+	void PrintText( Options const & iOptions, size_t iFileSize, MemoryUsage const & iMemory, std::vector< GeodesicError > const & iErrors,
+			std::vector< Stage > const & iStages )
+	{
+		std::printf( "points %zu, file %.1f MB, repeat %u\n", iOptions.generator.pointCount, iFileSize / 1e6, iOptions.repeat );
+		std::printf( "track %.1f MB, compressed %.1f MB (%.1fx)\n", iMemory.track / 1e6, iMemory.compressed / 1e6, double( iMemory.track ) / std::max< size_t >( iMemory.compressed, 1 ) );
+		for( GeodesicError const & error: iErrors )
+			std::printf( "%s vs vincenty: track length %.4f%%, long segments up to %.4f%%\n", error.name.c_str(), error.trackRelative * 100, error.longMaxRelative * 100 );
+		std::printf( "%-22s %12s %12s %10s %14s\n", "stage", "best s", "median s", "MB/s", "items/s" );
+		for( Stage const & stage: iStages ) {
+			double const best = stage.Best();
+			std::printf( "%-22s %12.6f %12.6f ", stage.name.c_str(), best, stage.Median() );
+			if( stage.bytes )
+				std::printf( "%10.1f ", stage.bytes / 1e6 / best );
+			else
+				std::printf( "%10s ", "-" );
+			std::printf( "%14.0f\n", stage.items / best );
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	void PrintJson( Options const & iOptions, size_t iFileSize, MemoryUsage const & iMemory, std::vector< GeodesicError > const & iErrors,
+			std::vector< Stage > const & iStages )
+	{
+		GeneratorOptions const & generator = iOptions.generator;
+		std::printf( "{\n  \"points\": %zu, \"seed\": %llu, \"period\": %ld, \"gaps\": %g, \"disorder\": %g, \"malformed\": %g, "
+			"\"extra_tags\": %s, \"file_bytes\": %zu, \"repeat\": %u,\n  \"track_bytes\": %zu, \"compressed_bytes\": %zu,\n",
+			generator.pointCount, (unsigned long long)generator.seed, long( generator.samplePeriod ), generator.gapRate,
+			generator.disorderRate, generator.malformedRate, generator.extraTags ? "true" : "false", iFileSize, iOptions.repeat,
+			iMemory.track, iMemory.compressed );
+		std::printf( "  \"geodesic_errors\": [" );
+		for( size_t i = 0; i < iErrors.size(); ++i )
+			std::printf( "%s{\"name\": \"%s\", \"track_relative\": %.9g, \"long_max_relative\": %.9g}", i ? ", " : "",
+				iErrors[ i ].name.c_str(), iErrors[ i ].trackRelative, iErrors[ i ].longMaxRelative );
+		std::printf( "],\n  \"stages\": [\n" );
+		for( size_t i = 0; i < iStages.size(); ++i ) {
+			Stage const & stage = iStages[ i ];
+			double const best = stage.Best();
+			std::printf( "    {\"name\": \"%s\", \"best_seconds\": %.9f, \"median_seconds\": %.9f, \"items\": %zu, \"items_per_s\": %.1f",
+				stage.name.c_str(), best, stage.Median(), stage.items, stage.items / best );
+			if( stage.bytes )
+				std::printf( ", \"bytes\": %zu, \"mb_per_s\": %.3f", stage.bytes, stage.bytes / 1e6 / best );
+			std::printf( "}%s\n", i + 1 < iStages.size() ? "," : "" );
+		}
+		std::printf( "  ]\n}\n" );
+	}
+}
+
+int main( int argc, char * argv[] )
+{
+#ifdef GPX_BENCH_RENDER
+	QApplication application( argc, argv ); // fonts for the graph labels, QT_QPA_PLATFORM=offscreen works without a display
+#endif
+	Options options;
+	if( !ParseArguments( argc, argv, options ) ) {
+		PrintUsage();
+		return 2;
+	}
+
+	std::vector< Stage > stages;
+	size_t const points = options.generator.pointCount;
+	stages.push_back( Measure( "generate", 1, 0, points, [&] {
+		std::ofstream file( options.file, std::ios::binary | std::ios::out | std::ios::trunc );
+		GenerateGpx( options.generator, file );
+		return size_t( file.tellp() );
+	} ) );
+	std::ifstream sizeProbe( options.file, std::ios::binary | std::ios::ate );
+	size_t const fileSize = sizeProbe ? size_t( sizeProbe.tellg() ) : 0;
+	if( fileSize == 0 ) {
+		std::cerr << "gpx_bench: Can't write " << options.file << std::endl;
+		return 1;
+	}
+
+	// parsing: a stream through the chunked parser, the mapped file by one and by all threads (also with all fields), the binary cache
+	stages.push_back( Measure( "parse_stream", options.repeat, fileSize, points, [&] {
+		std::ifstream file( options.file, std::ios::binary );
+		return gpx::ReadTrack( file ).size();
+	} ) );
+	gpx::ReadOptions single;
+	single.threadCount = 1;
+	stages.push_back( Measure( "read_track", options.repeat, fileSize, points, [&] { return gpx::ReadTrack( options.file, single ).size(); } ) );
+	stages.push_back( Measure( "read_track_parallel", options.repeat, fileSize, points, [&] { return gpx::ReadTrack( options.file ).size(); } ) );
+	gpx::ReadOptions fields;
+	fields.fields = gpx::ALL_FIELDS;
+	fields.deviceSpeed = true;
+	stages.push_back( Measure( "read_track_fields", options.repeat, fileSize, points, [&] { return gpx::ReadTrack( options.file, fields ).size(); } ) );
+	// the same track in a gzip archive, MB/s of the decompressed data to compare with read_track
+	std::string const gzipFile = options.file + ".gz";
+	if( WriteGzip( options.file, gzipFile ) )
+		stages.push_back( Measure( "read_track_gzip", options.repeat, fileSize, points, [&] { return gpx::ReadTrack( gzipFile, single ).size(); } ) );
+
+	gpx::ReadOptions cached;
+	cached.useCache = true;
+	Track const track = gpx::ReadTrack( options.file, cached ); // writes the cache
+	stages.push_back( Measure( "read_cache", options.repeat, fileSize, points, [&] { return gpx::ReadTrack( options.file, cached ).size(); } ) );
+
+	// analysis of the parsed track
+	stages.push_back( Measure( "track_info", options.repeat, 0, track.size(), [&] {
+		TrackInfo info;
+		return size_t( info.calculate( track, options.speedLimit ) );
+	} ) );
+	gpx::SimplifyOptions simplify;
+	simplify.toleranceMeters = 5;
+	simplify.speedLimits = { options.speedLimit };
+	stages.push_back( Measure( "simplify", options.repeat, 0, track.size(), [&] { return gpx::SimplifyTrack( track, simplify ).size(); } ) );
+	// the compressed store: encoding, a full decoding and the summary decoded block by block
+	stages.push_back( Measure( "compress", options.repeat, 0, track.size(), [&] { return CompressedTrack( track ).MemoryUsage(); } ) );
+	CompressedTrack const compressed( track );
+	MemoryUsage const memory = { track.memoryUsage(), compressed.MemoryUsage() };
+	stages.push_back( Measure( "decompress", options.repeat, 0, track.size(), [&] { return compressed.Decompress().size(); } ) );
+	stages.push_back( Measure( "compressed_track_info", options.repeat, 0, track.size(), [&] {
+		TrackInfo info;
+		return size_t( info.calculate( compressed, options.speedLimit ) );
+	} ) );
+	// geodesic policies: the cost per segment of the track and the error against the ellipsoid
+	stages.push_back( Measure( "dist_equirectangular", options.repeat, 0, track.size(), [&] { return size_t( TrackMeters< gpx::Equirectangular >( track ) ); } ) );
+	stages.push_back( Measure( "dist_haversine", options.repeat, 0, track.size(), [&] { return size_t( TrackMeters< gpx::Haversine >( track ) ); } ) );
+	stages.push_back( Measure( "dist_vincenty", options.repeat, 0, track.size(), [&] { return size_t( TrackMeters< gpx::Vincenty >( track ) ); } ) );
+	TSegments const longSegments = LongSegments( options.generator.seed, 10000 );
+	std::vector< GeodesicError > const errors = { MeasureError< gpx::Equirectangular >( "equirectangular", track, longSegments ),
+			MeasureError< gpx::Haversine >( "haversine", track, longSegments ) };
+	stages.push_back( Measure( "speed_index_build", options.repeat, 0, track.size(), [&] { return size_t( SpeedIndex( track ).IsValid() ); } ) );
+	SpeedIndex const speedIndex( track );
+	size_t const queryCount = 1000;
+	stages.push_back( Measure( "speed_index_calculate", options.repeat, 0, queryCount, [&] {
+		size_t result = 0;
+		TrackInfo info;
+		for( size_t i = 0; i < queryCount; ++i )
+			result += speedIndex.Calculate( float( i % 200 ), info ) ? size_t( info.overSpeedCount ) : 0;
+		return result;
+	} ) );
+
+#ifdef GPX_BENCH_RENDER
+	// the graph as it is saved to a picture
+	TrackInfo info;
+	info.calculate( track, options.speedLimit );
+	GraphWidget graph;
+	graph.setTrack( std::make_shared< Track const >( track ), info.maxSpeed, options.speedLimit );
+	stages.push_back( Measure( "render_graph", options.repeat, 0, track.size(), [&] { return size_t( graph.makeSpeedImageForSave().width() ); } ) );
+#endif
+
+	if( !options.keep ) {
+		std::remove( options.file.c_str() );
+		std::remove( gzipFile.c_str() );
+		std::remove( gpx::TrackCachePath( options.file ).c_str() );
+	}
+
+	if( options.json )
+		PrintJson( options, fileSize, memory, errors, stages );
+	else
+		PrintText( options, fileSize, memory, errors, stages );
+	return 0;
+}
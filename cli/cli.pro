@@ -0,0 +1,13 @@
+# gpx_batch - headless batch analysis of GPX tracks.
+
+include(../common.pri)
+
+CONFIG += console
+CONFIG -= qt app_bundle
+
+TARGET = gpx_batch
+TEMPLATE = app
+
+include(../core/core.pri)
+
+SOURCES += main.cpp
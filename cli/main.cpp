@@ -0,0 +1,454 @@
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <tuple>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+#include "Track.h"
+#include "TrackInfo.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include "SpatialIndex.h"
+#include "TrackRollup.h"
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	enum class EFormat { Csv, Json };
+
+	struct Geofence
+	{
+		std::string name;
+		GeoPolygon  area;
+	};
+
+	struct Options
+	{
+		float                      speedLimit = 105;
+		EFormat                    format = EFormat::Csv;
+		unsigned                   threadCount = 0;
+		bool                       useCache = false;
+		double                     simplifyMeters = 0;
+		long                       gapTime = gpx::DEFAULT_GAP_TIME;
+		bool                       deviceSpeed = false;
+		gpx::EGeodesic             geodesic = gpx::EGeodesic::Equirectangular;
+		std::string                tracePath;
+		std::string                summariesPath;
+		bool                       rollup = false;
+		gpx::EPeriod               rollupPeriod = gpx::EPeriod::Day;
+		std::vector< Geofence >    geofences;
+		std::vector< std::string > inputs;
+	};
+
+	/// Analysis result of one track file.
+	struct Row
+	{
+		std::string file;
+		size_t      positionCount = 0;
+		TrackInfo   info;
+		std::vector< double > insideSeconds; /// time inside of every geofence
+		std::vector< gpx::DaySummary > days; /// filled for --summaries
+		std::string error; /// empty when the track is analyzed
+	};
+
+	//-------------------------------------------------------------------------
+	void PrintUsage()
+	{
+		std::cerr << "Usage: gpx_batch [--speed-limit <km/h>] [--format csv|json] [--threads <n>] [--cache] [--trace <file>]\n"
+			"                 [--gap-time <s>] [--device-speed] [--simplify <m>] [--geofences <file>] [--summaries <file>]\n"
+			"                 [--geodesic equirectangular|haversine|vincenty] <file or directory>...\n"
+			"       gpx_batch --rollup day|week|month [--format csv|json] [--threads <n>] <summaries file>...\n"
+			"Analyzes GPX tracks, directories are searched for *.gpx, *.gpx.gz and *.gpx.zst recursively.\n"
+			"--cache keeps parsed tracks in .gpxc files next to them and reuses them while the track is not changed.\n"
+			"--gap-time sets pauses in seconds which are counted as stops, 60 by default.\n"
+			"--device-speed takes speeds of positions from their <speed> tags, positions without it get the calculated one.\n"
+			"--geodesic sets the formula of distances and speeds: equirectangular (the default, the fastest), haversine\n"
+			"  (great circle) or vincenty (WGS-84 ellipsoid, the most exact and the slowest).\n"
+			"--simplify drops positions deviating from the rest of the track by less than <m> meters before the analysis,\n"
+			"  over speed count and duration for --speed-limit are kept exact.\n"
+			"--trace writes timings of processing stages as Chrome trace JSON and prints their summary to stderr.\n"
+			"--geofences adds seconds spent inside every polygon of the file, a line of it is\n"
+			"  <name> <lon>,<lat> <lon>,<lat> <lon>,<lat>...   lines starting with # are skipped.\n"
+			"--summaries writes daily summaries of the tracks, the vehicle of a track is its file name without\n"
+			"  .gpx, .gpx.gz or .gpx.zst, so compressed and plain files of a vehicle are summed together.\n"
+			"--rollup sums summaries of --summaries runs per vehicle and period, per period, per vehicle\n"
+			"  and for the whole fleet, * stands for all vehicles or all periods.\n"
+			"One result row per file is printed to stdout.\n";
+	}
+
+	//-------------------------------------------------------------------------
+	bool ReadGeofences( std::string const & iPath, std::vector< Geofence > & oGeofences )
+	{
+		std::ifstream file( iPath );
+		if( !file ) {
+			std::cerr << "gpx_batch: Can't open geofences " << iPath << "\n";
+			return false;
+		}
+		std::string line;
+		for( size_t lineNumber = 1; std::getline( file, line ); ++lineNumber ) {
+			std::istringstream fields( line );
+			Geofence geofence;
+			if( !( fields >> geofence.name ) || geofence.name[ 0 ] == '#' )
+				continue;
+			std::vector< double > x, y;
+			std::string point;
+			while( fields >> point ) {
+				char * end = nullptr;
+				x.push_back( std::strtod( point.c_str(), &end ) );
+				if( *end != ',' )
+					break;
+				y.push_back( std::strtod( end + 1, &end ) );
+				if( *end != '\0' )
+					break;
+			}
+			if( x.size() != y.size() || x.size() < 3 ) {
+				std::cerr << "gpx_batch: " << iPath << ":" << lineNumber << ": a geofence needs at least 3 <lon>,<lat> points\n";
+				return false;
+			}
+			geofence.area = GeoPolygon( std::move( x ), std::move( y ) );
+			oGeofences.push_back( std::move( geofence ) );
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------------------------
+	bool ParseArguments( int argc, char * argv[], Options & oOptions )
+	{
+		for( int i = 1; i < argc; ++i ) {
+			std::string const arg = argv[ i ];
+			bool const hasValue = i + 1 < argc;
+			if( arg == "--speed-limit" && hasValue ) {
+				oOptions.speedLimit = std::strtof( argv[ ++i ], nullptr );
+			} else if( arg == "--format" && hasValue ) {
+				std::string const format = argv[ ++i ];
+				if( format == "csv" )
+					oOptions.format = EFormat::Csv;
+				else if( format == "json" )
+					oOptions.format = EFormat::Json;
+				else
+					return false;
+			} else if( arg == "--threads" && hasValue ) {
+				oOptions.threadCount = unsigned( std::strtoul( argv[ ++i ], nullptr, 10 ) );
+			} else if( arg == "--cache" ) {
+				oOptions.useCache = true;
+			} else if( arg == "--gap-time" && hasValue ) {
+				oOptions.gapTime = std::strtol( argv[ ++i ], nullptr, 10 );
+			} else if( arg == "--device-speed" ) {
+				oOptions.deviceSpeed = true;
+			} else if( arg == "--geodesic" && hasValue ) {
+				std::string const geodesic = argv[ ++i ];
+				if( geodesic == "equirectangular" )
+					oOptions.geodesic = gpx::EGeodesic::Equirectangular;
+				else if( geodesic == "haversine" )
+					oOptions.geodesic = gpx::EGeodesic::Haversine;
+				else if( geodesic == "vincenty" )
+					oOptions.geodesic = gpx::EGeodesic::Vincenty;
+				else
+					return false;
+			} else if( arg == "--simplify" && hasValue ) {
+				oOptions.simplifyMeters = std::strtod( argv[ ++i ], nullptr );
+			} else if( arg == "--trace" && hasValue ) {
+				oOptions.tracePath = argv[ ++i ];
+			} else if( arg == "--summaries" && hasValue ) {
+				oOptions.summariesPath = argv[ ++i ];
+			} else if( arg == "--rollup" && hasValue ) {
+				std::string const period = argv[ ++i ];
+				oOptions.rollup = true;
+				if( period == "day" )
+					oOptions.rollupPeriod = gpx::EPeriod::Day;
+				else if( period == "week" )
+					oOptions.rollupPeriod = gpx::EPeriod::Week;
+				else if( period == "month" )
+					oOptions.rollupPeriod = gpx::EPeriod::Month;
+				else
+					return false;
+			} else if( arg == "--geofences" && hasValue ) {
+				if( !ReadGeofences( argv[ ++i ], oOptions.geofences ) )
+					return false;
+			} else if( arg == "-h" || arg == "--help" || ( !arg.empty() && arg[ 0 ] == '-' ) ) {
+				return false;
+			} else {
+				oOptions.inputs.push_back( arg );
+			}
+		}
+		return !oOptions.inputs.empty();
+	}
+
+	//-------------------------------------------------------------------------
+	/// true when @a iName ends with @a iSuffix (lowercase) in any case and is longer than it.
+	bool EndsWith( std::string const & iName, std::string const & iSuffix )
+	{
+		return iName.size() > iSuffix.size() && std::equal( iSuffix.begin(), iSuffix.end(), iName.end() - iSuffix.size(),
+				[]( char iLeft, char iRight ) { return iLeft == ::tolower( static_cast< unsigned char >( iRight ) ); } );
+	}
+
+	//-------------------------------------------------------------------------
+	bool IsGpxFile( fs::path const & iPath )
+	{
+		std::string const name = iPath.filename().string();
+		return EndsWith( name, ".gpx" ) || EndsWith( name, ".gpx.gz" ) || EndsWith( name, ".gpx.zst" ); // compressed ones are read as they are
+	}
+
+	//-------------------------------------------------------------------------
+	/// Vehicle of a track for --summaries: the file name without .gpx and the compression suffix,
+	/// so car.gpx and car.gpx.gz are the same vehicle.
+	std::string VehicleName( std::string const & iFile )
+	{
+		std::string name = fs::path( iFile ).filename().string();
+		for( std::string const suffix: { ".gz", ".zst", ".gpx" } )
+			if( EndsWith( name, suffix ) )
+				name.resize( name.size() - suffix.size() );
+		return name;
+	}
+
+	//-------------------------------------------------------------------------
+	std::vector< std::string > CollectFiles( std::vector< std::string > const & iInputs )
+	{
+		std::vector< std::string > result;
+		for( std::string const & input: iInputs ) {
+			std::error_code error;
+			if( !fs::is_directory( input, error ) ) {
+				result.push_back( input ); // a missing file is reported in its row
+				continue;
+			}
+			std::vector< std::string > files;
+			for( fs::recursive_directory_iterator it( input, error ), end; !error && it != end; it.increment( error ) )
+				if( it->is_regular_file( error ) && IsGpxFile( it->path() ) )
+					files.push_back( it->path().string() );
+			std::sort( files.begin(), files.end() );
+			result.insert( result.end(), files.begin(), files.end() );
+		}
+		return result;
+	}
+
+	//-------------------------------------------------------------------------
+	void AnalyzeFile( Options const & iOptions, Row & ioRow )
+	{
+		try {
+			gpx::ReadOptions options;
+			options.threadCount = 1; // files are processed in parallel already
+			options.useCache = iOptions.useCache;
+			options.gapTime = iOptions.gapTime;
+			options.deviceSpeed = iOptions.deviceSpeed;
+			options.geodesic = iOptions.geodesic;
+			options.simplify.toleranceMeters = iOptions.simplifyMeters;
+			options.simplify.speedLimits = { iOptions.speedLimit };
+			auto const track = std::make_shared< Track const >( gpx::ReadTrack( ioRow.file, options ) );
+			ioRow.positionCount = track->size();
+			if( track->size() < 2 )
+				ioRow.error = "no track";
+			else if( !gpx::WithGeodesic( iOptions.geodesic, [&]( auto iGeodesic ) { return ioRow.info.calculate< decltype( iGeodesic ) >( *track, iOptions.speedLimit ); } ) )
+				ioRow.error = "negative speed";
+			if( !ioRow.error.empty() )
+				return;
+			if( !iOptions.summariesPath.empty() )
+				gpx::WithGeodesic( iOptions.geodesic, [&]( auto iGeodesic ) {
+					return gpx::SummarizeDays< decltype( iGeodesic ) >( VehicleName( ioRow.file ), *track, iOptions.speedLimit, ioRow.days );
+				} );
+			if( iOptions.geofences.empty() )
+				return;
+
+			SpatialIndex const index( track );
+			for( Geofence const & geofence: iOptions.geofences )
+				ioRow.insideSeconds.push_back( index.InsideDuration( geofence.area ) );
+		} catch( std::exception const & e ) {
+			ioRow.error = e.what();
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	std::string CsvQuoted( std::string const & iStr )
+	{
+		std::string result = "\"";
+		for( char c: iStr ) {
+			if( c == '"' )
+				result += '"';
+			result += c;
+		}
+		return result + "\"";
+	}
+
+	//-------------------------------------------------------------------------
+	std::string JsonQuoted( std::string const & iStr )
+	{
+		std::string result = "\"";
+		for( unsigned char c: iStr ) {
+			if( c == '"' || c == '\\' ) {
+				result += '\\';
+				result += char( c );
+			} else if( c < 0x20 ) {
+				char escaped[ 8 ];
+				std::snprintf( escaped, sizeof( escaped ), "\\u%04x", c );
+				result += escaped;
+			} else {
+				result += char( c );
+			}
+		}
+		return result + "\"";
+	}
+
+	//-------------------------------------------------------------------------
+	void PrintCsv( std::vector< Row > const & iRows, Options const & iOptions )
+	{
+		std::printf( "file,positions,speed_limit,average_speed,max_speed,min_speed,distance_km,drive_duration,"
+			"idle_count,idle_duration,over_speed_count,over_speed_duration," );
+		for( Geofence const & geofence: iOptions.geofences )
+			std::printf( "%s,", CsvQuoted( "inside_" + geofence.name ).c_str() );
+		std::printf( "error\n" );
+		for( Row const & row: iRows ) {
+			TrackInfo const & info = row.info;
+			std::printf( "%s,%zu,%.1f,%.3f,%.3f,%.3f,%.3f,%ld,%d,%ld,%d,%ld,", CsvQuoted( row.file ).c_str(), row.positionCount,
+				iOptions.speedLimit, info.averageSpeed, info.maxSpeed, info.minSpeed, info.distance, info.driveDuration,
+				info.idleCount, info.idleDuration, info.overSpeedCount, info.overSpeedDuration );
+			for( size_t i = 0; i < iOptions.geofences.size(); ++i ) {
+				if( i < row.insideSeconds.size() ) // a failed track has no durations
+					std::printf( "%.0f", row.insideSeconds[ i ] );
+				std::printf( "," );
+			}
+			std::printf( "%s\n", CsvQuoted( row.error ).c_str() );
+		}
+	}
+
+	//-------------------------------------------------------------------------
+	void PrintJson( std::vector< Row > const & iRows, Options const & iOptions )
+	{
+		std::printf( "[\n" );
+		for( size_t i = 0; i < iRows.size(); ++i ) {
+			Row const & row = iRows[ i ];
+			TrackInfo const & info = row.info;
+			std::printf( "  {\"file\": %s, \"positions\": %zu, \"speed_limit\": %.1f", JsonQuoted( row.file ).c_str(), row.positionCount, iOptions.speedLimit );
+			if( row.error.empty() )
+				std::printf( ", \"average_speed\": %.3f, \"max_speed\": %.3f, \"min_speed\": %.3f, \"distance_km\": %.3f, "
+					"\"drive_duration\": %ld, \"idle_count\": %d, \"idle_duration\": %ld, \"over_speed_count\": %d, \"over_speed_duration\": %ld",
+					info.averageSpeed, info.maxSpeed, info.minSpeed, info.distance, info.driveDuration,
+					info.idleCount, info.idleDuration, info.overSpeedCount, info.overSpeedDuration );
+			if( !row.insideSeconds.empty() ) {
+				std::printf( ", \"inside\": {" );
+				for( size_t j = 0; j < row.insideSeconds.size(); ++j )
+					std::printf( "%s%s: %.0f", j ? ", " : "", JsonQuoted( iOptions.geofences[ j ].name ).c_str(), row.insideSeconds[ j ] );
+				std::printf( "}" );
+			}
+			if( !row.error.empty() )
+				std::printf( ", \"error\": %s", JsonQuoted( row.error ).c_str() );
+			std::printf( "}%s\n", i + 1 < iRows.size() ? "," : "" );
+		}
+		std::printf( "]\n" );
+	}
+
+	//-------------------------------------------------------------------------
+	/// Rows of the rollup report: vehicle, period and the summary, empty names are printed as *.
+	std::vector< std::tuple< std::string, std::string, TrackInfo > > RollupRows( gpx::RollupResult const & iResult )
+	{
+		std::vector< std::tuple< std::string, std::string, TrackInfo > > result;
+		for( auto const & vehiclePeriod: iResult.vehiclePeriods )
+			result.emplace_back( vehiclePeriod.first.first, gpx::FormatDay( vehiclePeriod.first.second ), vehiclePeriod.second );
+		for( auto const & period: iResult.periods )
+			result.emplace_back( "", gpx::FormatDay( period.first ), period.second );
+		for( auto const & vehicle: iResult.vehicles )
+			result.emplace_back( vehicle.first, "", vehicle.second );
+		result.emplace_back( "", "", iResult.fleet );
+		return result;
+	}
+
+	//-------------------------------------------------------------------------
+	int RunRollup( Options const & iOptions )
+	{
+		std::vector< gpx::DaySummary > summaries;
+		for( std::string const & input: iOptions.inputs ) {
+			std::ifstream file( input );
+			if( !file || !gpx::ReadSummaries( file, summaries ) ) {
+				std::cerr << "gpx_batch: Can't read summaries " << input << "\n";
+				return 1;
+			}
+		}
+		gpx::RollupResult result;
+		{
+			ThreadPool pool( iOptions.threadCount );
+			if( !gpx::Rollup( summaries, iOptions.rollupPeriod, pool, result ) ) {
+				std::cerr << "gpx_batch: Summaries of different speed limits can't be rolled up\n";
+				return 1;
+			}
+		}
+
+		auto const rows = RollupRows( result );
+		bool const json = iOptions.format == EFormat::Json;
+		std::printf( json ? "[\n" : "vehicle,period,speed_limit,average_speed,max_speed,min_speed,distance_km,drive_duration,"
+			"idle_count,idle_duration,over_speed_count,over_speed_duration\n" );
+		for( size_t i = 0; i < rows.size(); ++i ) {
+			auto const & [ vehicle, period, info ] = rows[ i ];
+			std::string const vehicleName = vehicle.empty() ? "*" : vehicle;
+			std::string const periodName = period.empty() ? "*" : period;
+			if( json )
+				std::printf( "  {\"vehicle\": %s, \"period\": %s, \"speed_limit\": %.1f, \"average_speed\": %.3f, \"max_speed\": %.3f, "
+					"\"min_speed\": %.3f, \"distance_km\": %.3f, \"drive_duration\": %ld, \"idle_count\": %d, \"idle_duration\": %ld, "
+					"\"over_speed_count\": %d, \"over_speed_duration\": %ld}%s\n", JsonQuoted( vehicleName ).c_str(), JsonQuoted( periodName ).c_str(),
+					info.speedLimit, info.averageSpeed, info.maxSpeed, info.minSpeed, info.distance, info.driveDuration,
+					info.idleCount, info.idleDuration, info.overSpeedCount, info.overSpeedDuration, i + 1 < rows.size() ? "," : "" );
+			else
+				std::printf( "%s,%s,%.1f,%.3f,%.3f,%.3f,%.3f,%ld,%d,%ld,%d,%ld\n", CsvQuoted( vehicleName ).c_str(), periodName.c_str(),
+					info.speedLimit, info.averageSpeed, info.maxSpeed, info.minSpeed, info.distance, info.driveDuration,
+					info.idleCount, info.idleDuration, info.overSpeedCount, info.overSpeedDuration );
+		}
+		if( json )
+			std::printf( "]\n" );
+		return 0;
+	}
+}
+
+int main( int argc, char * argv[] )
+{
+	Options options;
+	if( !ParseArguments( argc, argv, options ) ) {
+		PrintUsage();
+		return 2;
+	}
+
+	if( options.rollup )
+		return RunRollup( options );
+
+	Profiler::SetEnabled( !options.tracePath.empty() );
+	std::vector< std::string > const files = CollectFiles( options.inputs );
+	std::vector< Row > rows( files.size() );
+	{
+		ThreadPool pool( options.threadCount );
+		for( size_t i = 0; i < files.size(); ++i ) {
+			rows[ i ].file = files[ i ];
+			Row & row = rows[ i ];
+			pool.Submit( [&options, &row] { AnalyzeFile( options, row ); } );
+		}
+		pool.Wait();
+	}
+
+	if( Profiler::IsEnabled() ) {
+		std::ofstream trace( options.tracePath );
+		Profiler::WriteChromeTrace( trace );
+		if( !trace )
+			std::cerr << "gpx_batch: Can't write trace " << options.tracePath << "\n";
+		std::cerr << Profiler::Summary() << "\n";
+	}
+
+	if( !options.summariesPath.empty() ) {
+		std::vector< gpx::DaySummary > days;
+		for( Row const & row: rows )
+			days.insert( days.end(), row.days.begin(), row.days.end() );
+		std::ofstream summaries( options.summariesPath );
+		gpx::WriteSummaries( summaries, days );
+		if( !summaries )
+			std::cerr << "gpx_batch: Can't write summaries " << options.summariesPath << "\n";
+	}
+
+	if( options.format == EFormat::Json )
+		PrintJson( rows, options );
+	else
+		PrintCsv( rows, options );
+
+	bool const allAnalyzed = std::all_of( rows.begin(), rows.end(), []( Row const & iRow ) { return iRow.error.empty(); } );
+	return allAnalyzed ? 0 : 1;
+}
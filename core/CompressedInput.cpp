@@ -0,0 +1,228 @@
+#include <memory>
+#include <algorithm>
+#include <stdexcept>
+#include <zlib.h>
+#ifdef GPX_WITH_ZSTD
+#include <zstd.h>
+#endif
+#include "CompressedInput.h"
+#include "Profiler.h"
+
+unsigned char const GZIP_MAGIC[] = { 0x1f, 0x8b };
+unsigned char const ZSTD_MAGIC[] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+//-------------------------------------------------------------------------
+CompressedInput::ECompression CompressedInput::Detect( std::string const & iFilePath )
+{
+	std::ifstream file( iFilePath.c_str(), std::ios::binary | std::ios::in );
+	unsigned char magic[ sizeof( ZSTD_MAGIC ) ] = {};
+	file.read( reinterpret_cast< char * >( magic ), sizeof( magic ) );
+	size_t const read = size_t( file.gcount() );
+	if( read >= sizeof( GZIP_MAGIC ) && std::equal( GZIP_MAGIC, GZIP_MAGIC + sizeof( GZIP_MAGIC ), magic ) )
+		return ECompression::Gzip;
+	if( read >= sizeof( ZSTD_MAGIC ) && std::equal( ZSTD_MAGIC, ZSTD_MAGIC + sizeof( ZSTD_MAGIC ), magic ) )
+		return ECompression::Zstd;
+	return ECompression::None;
+}
+
+//-------------------------------------------------------------------------
+CompressedInput::CompressedInput( std::string const & iFilePath, ECompression iCompression )
+	: m_compression( iCompression )
+	, m_file( iFilePath.c_str(), std::ios::binary | std::ios::in | std::ios::ate )
+	, m_compressedRead( 0 )
+	, m_stream( this )
+{
+	if( !m_file )
+		throw std::logic_error( "gpx: Can't open GPX track file: " + iFilePath );
+#ifndef GPX_WITH_ZSTD
+	if( m_compression == ECompression::Zstd )
+		throw std::logic_error( "gpx: zstd compressed tracks are not supported by this build: " + iFilePath );
+#endif
+	std::streamoff const size = m_file.tellg();
+	m_compressedSize = size > 0 ? uint64_t( size ) : 0;
+	m_file.seekg( 0 );
+
+	m_stream.exceptions( std::ios::badbit ); // the reader gets the error of the decompression itself
+	m_thread = std::thread( &CompressedInput::Decompress, this );
+}
+
+//-------------------------------------------------------------------------
+CompressedInput::~CompressedInput()
+{
+	{
+		std::lock_guard< std::mutex > lock( m_mutex );
+		m_stopped = true;
+	}
+	m_changed.notify_all();
+	m_thread.join();
+}
+
+//-------------------------------------------------------------------------
+CompressedInput::int_type CompressedInput::underflow()
+{
+	std::unique_lock< std::mutex > lock( m_mutex );
+	if( !m_current.empty() ) {
+		m_free.push_back( std::move( m_current ) );
+		m_current.clear();
+	}
+	m_changed.wait( lock, [this] { return !m_ready.empty() || m_finished; } );
+	if( m_ready.empty() ) {
+		if( m_error )
+			std::rethrow_exception( m_error );
+		return traits_type::eof();
+	}
+	m_current = std::move( m_ready.front() );
+	m_ready.pop_front();
+	lock.unlock();
+	m_changed.notify_all();
+
+	char * const data = &m_current[ 0 ];
+	setg( data, data, data + m_current.size() );
+	return traits_type::to_int_type( *data );
+}
+
+//-------------------------------------------------------------------------
+void CompressedInput::Decompress()
+{
+	std::exception_ptr error;
+	try {
+		ProfileScope const scope( "Decompress" );
+		if( m_compression == ECompression::Gzip )
+			DecompressGzip();
+		else if( m_compression == ECompression::Zstd )
+			DecompressZstd();
+	} catch( ... ) {
+		error = std::current_exception();
+	}
+
+	std::lock_guard< std::mutex > lock( m_mutex );
+	m_error = error;
+	m_finished = true;
+	m_changed.notify_all();
+}
+
+//-------------------------------------------------------------------------
+void CompressedInput::DecompressGzip()
+{
+	z_stream zs = {};
+	if( ::inflateInit2( &zs, 15 + 16 ) != Z_OK ) // 15 - the largest window, +16 - gzip header
+		throw std::runtime_error( "gpx: Can't initialize gzip decompression" );
+	std::unique_ptr< z_stream, int ( * )( z_streamp ) > const guard( &zs, ::inflateEnd );
+
+	std::string output = TakeBuffer();
+	size_t filled = 0;
+	bool memberEnd = false;
+	while( true ) {
+		// new input only when the previous call had room for all its output
+		if( zs.avail_in == 0 && filled < output.size() ) {
+			if( !ReadInput() )
+				break;
+			zs.next_in = reinterpret_cast< Bytef * >( &m_input[ 0 ] );
+			zs.avail_in = uInt( m_input.size() );
+		}
+		if( memberEnd ) {
+			::inflateReset( &zs ); // the next member of the file
+			memberEnd = false;
+		}
+		if( filled == output.size() ) {
+			if( !Push( output ) )
+				return;
+			output = TakeBuffer();
+			filled = 0;
+		}
+
+		zs.next_out = reinterpret_cast< Bytef * >( &output[ filled ] );
+		zs.avail_out = uInt( output.size() - filled );
+		int const result = ::inflate( &zs, Z_NO_FLUSH );
+		if( result == Z_STREAM_END )
+			memberEnd = true;
+		else if( result != Z_OK && result != Z_BUF_ERROR )
+			throw std::runtime_error( std::string( "gpx: Corrupted gzip data: " ) + ( zs.msg ? zs.msg : "unknown error" ) );
+		filled = output.size() - zs.avail_out;
+	}
+	if( !memberEnd )
+		throw std::runtime_error( "gpx: Truncated gzip data" );
+
+	output.resize( filled );
+	Push( output );
+}
+
+//-------------------------------------------------------------------------
+void CompressedInput::DecompressZstd()
+{
+#ifdef GPX_WITH_ZSTD
+	std::unique_ptr< ZSTD_DStream, size_t ( * )( ZSTD_DStream * ) > const stream( ::ZSTD_createDStream(), ::ZSTD_freeDStream );
+	if( !stream )
+		throw std::runtime_error( "gpx: Can't initialize zstd decompression" );
+
+	std::string output = TakeBuffer();
+	ZSTD_inBuffer input = { nullptr, 0, 0 };
+	ZSTD_outBuffer out = { &output[ 0 ], output.size(), 0 };
+	size_t hint = 0; // 0 - the last frame is complete
+	while( true ) {
+		// new input only when the previous call had room for all its output
+		if( input.pos == input.size && out.pos < out.size ) {
+			if( !ReadInput() )
+				break;
+			input = { m_input.data(), m_input.size(), 0 };
+		}
+		if( out.pos == out.size ) {
+			if( !Push( output ) )
+				return;
+			output = TakeBuffer();
+			out = { &output[ 0 ], output.size(), 0 };
+		}
+
+		hint = ::ZSTD_decompressStream( stream.get(), &out, &input );
+		if( ::ZSTD_isError( hint ) )
+			throw std::runtime_error( std::string( "gpx: Corrupted zstd data: " ) + ::ZSTD_getErrorName( hint ) );
+	}
+	if( hint != 0 )
+		throw std::runtime_error( "gpx: Truncated zstd data" );
+
+	output.resize( out.pos );
+	Push( output );
+#endif
+}
+
+//-------------------------------------------------------------------------
+bool CompressedInput::ReadInput()
+{
+	m_input.resize( COMPRESSED_CHUNK_SIZE );
+	m_file.read( &m_input[ 0 ], std::streamsize( m_input.size() ) );
+	size_t const read = size_t( m_file.gcount() );
+	m_input.resize( read );
+	if( m_file.bad() )
+		throw std::runtime_error( "gpx: Error reading a compressed track file" );
+	m_compressedRead.fetch_add( read, std::memory_order_relaxed );
+	return read > 0;
+}
+
+//-------------------------------------------------------------------------
+std::string CompressedInput::TakeBuffer()
+{
+	std::string result;
+	{
+		std::lock_guard< std::mutex > lock( m_mutex );
+		if( !m_free.empty() ) {
+			result = std::move( m_free.back() );
+			m_free.pop_back();
+		}
+	}
+	result.resize( DECOMPRESSED_CHUNK_SIZE );
+	return result;
+}
+
+//-------------------------------------------------------------------------
+bool CompressedInput::Push( std::string & ioChunk )
+{
+	std::unique_lock< std::mutex > lock( m_mutex );
+	m_changed.wait( lock, [this] { return m_stopped || m_ready.size() < READY_CHUNKS; } );
+	if( m_stopped )
+		return false;
+	if( !ioChunk.empty() )
+		m_ready.push_back( std::move( ioChunk ) );
+	lock.unlock();
+	m_changed.notify_all();
+	return true;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fstream>
+#include <istream>
+#include <streambuf>
+#include <exception>
+#include <stdint.h>
+#include <condition_variable>
+
+/**
+ * @class CompressedInput is a decompressed stream of a gzip or zstd compressed file.
+ *
+ * The file is read and decompressed on a thread of its own into a few chunks of DECOMPRESSED_CHUNK_SIZE,
+ * the reader of Stream() takes them in order, so decompression runs in parallel with parsing and
+ * nothing is written to disk. Gzip files of several members are read as one stream, like zcat does.
+ * zstd is supported when the library is built with GPX_WITH_ZSTD.
+ *
+ * An error of reading or decompression is thrown by the reading functions of Stream() after the data
+ * decompressed before it.
+ */
+class CompressedInput : private std::streambuf
+{
+public:
+	enum class ECompression { None, Gzip, Zstd };
+
+	static size_t const COMPRESSED_CHUNK_SIZE = 1 << 18;   /// bytes read from the file at once
+	static size_t const DECOMPRESSED_CHUNK_SIZE = 1 << 20; /// bytes handed to the reader at once
+	static size_t const READY_CHUNKS = 4;                  /// decompressed chunks waiting for the reader at most
+
+	/// Compression of a file by its magic bytes, None for plain and unreadable files.
+	static ECompression Detect( std::string const & iFilePath );
+
+	/// Starts the decompression, throws std::logic_error when the file can't be opened
+	/// or the compression is not supported by the build.
+	CompressedInput( std::string const & iFilePath, ECompression iCompression );
+	~CompressedInput(); /// stops the decompression when the stream isn't read to the end
+
+	CompressedInput( CompressedInput const & ) = delete;
+	CompressedInput & operator=( CompressedInput const & ) = delete;
+
+	std::istream & Stream() { return m_stream; }
+
+	uint64_t CompressedSize() const { return m_compressedSize; }
+	/// Bytes of the file decompressed so far, may be called from any thread.
+	uint64_t CompressedRead() const { return m_compressedRead.load( std::memory_order_relaxed ); }
+
+private: // std::streambuf
+	int_type underflow() override;
+
+private: // helpers, called on the decompression thread
+	void Decompress();
+	void DecompressGzip();
+	void DecompressZstd();
+	/// Reads the next part of the file to m_input, false at the end of the file.
+	bool ReadInput();
+	/// A buffer of DECOMPRESSED_CHUNK_SIZE bytes, one given back by the reader when there is such.
+	std::string TakeBuffer();
+	/// Hands @a ioChunk to the reader, false when the reader is gone and the decompression should stop.
+	bool Push( std::string & ioChunk );
+
+private: // members
+	ECompression const          m_compression;
+	std::ifstream               m_file;
+	uint64_t                    m_compressedSize = 0;
+	std::atomic< uint64_t >     m_compressedRead;
+	std::string                 m_input;         /// the part of the file being decompressed
+
+	std::mutex                  m_mutex;         /// guards the members below up to m_current
+	std::condition_variable     m_changed;       /// a chunk is pushed or taken, the decompression finished or stopped
+	std::deque< std::string >   m_ready;         /// decompressed chunks in the order of data
+	std::vector< std::string >  m_free;          /// chunks read by the reader, their buffers are used again
+	bool                        m_finished = false;
+	bool                        m_stopped = false;
+	std::exception_ptr          m_error;         /// of the decompression, thrown after m_ready is read
+
+	std::string                 m_current;       /// the chunk being read, used by the reader only
+	std::istream                m_stream;
+	std::thread                 m_thread;        /// the last one, started when the rest is constructed
+};
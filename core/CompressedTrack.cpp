@@ -0,0 +1,277 @@
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "CompressedTrack.h"
+#include "Track.h"
+#include "TrackInfo.h"
+#include "SegmentKernels.h"
+#include "Profiler.h"
+
+double const COORDINATE_UNITS = 1e7; // fixed point units per degree
+double const SPEED_UNITS = 1e3;      // fixed point units per km/h
+double const DERIVED_SPEED_TOLERANCE = 1e-9; // km/h, a speed closer to the one by the distance to the next position is not stored
+
+//-------------------------------------------------------------------------
+inline uint64_t ZigZag( int64_t iValue )
+{
+	return ( uint64_t( iValue ) << 1 ) ^ uint64_t( iValue >> 63 );
+}
+
+//-------------------------------------------------------------------------
+inline int64_t UnZigZag( uint64_t iValue )
+{
+	return int64_t( iValue >> 1 ) ^ -int64_t( iValue & 1 );
+}
+
+//-------------------------------------------------------------------------
+/// Writes the difference of @a iValue and @a ioPrevious, iValue becomes the previous one.
+inline void WriteDelta( int64_t iValue, int64_t & ioPrevious, std::vector< uint8_t > & ioData )
+{
+	uint64_t value = ZigZag( int64_t( uint64_t( iValue ) - uint64_t( ioPrevious ) ) ); // wraps instead of overflow
+	ioPrevious = iValue;
+	while( value >= 0x80 ) {
+		ioData.push_back( uint8_t( value | 0x80 ) );
+		value >>= 7;
+	}
+	ioData.push_back( uint8_t( value ) );
+}
+
+//-------------------------------------------------------------------------
+/// Reads a difference written by WriteDelta and adds it to @a ioValue.
+inline void ReadDelta( uint8_t const * & ioData, int64_t & ioValue )
+{
+	uint64_t value = 0;
+	for( int shift = 0; ; shift += 7 ) {
+		uint8_t const byte = *ioData++;
+		value |= uint64_t( byte & 0x7F ) << shift;
+		if( !( byte & 0x80 ) )
+			break;
+	}
+	ioValue = int64_t( uint64_t( ioValue ) + uint64_t( UnZigZag( value ) ) );
+}
+
+//-------------------------------------------------------------------------
+inline double Coordinate( int64_t iFixed )
+{
+	return iFixed / COORDINATE_UNITS; // not a multiplication by the inverse: a decimal of the file is restored to the same double
+}
+
+//-------------------------------------------------------------------------
+inline double SegmentMeters( double iX, double iY, double iNextX, double iNextY )
+{
+	// the scalar kernel gives the same value wherever the segment is, so the encoder predicts the decoder exactly
+	double const x[ 2 ] = { iX, iNextX };
+	double const y[ 2 ] = { iY, iNextY };
+	double meters = 0;
+	gpx::SegmentDistancesScalar( x, y, 2, &meters );
+	return meters;
+}
+
+//-------------------------------------------------------------------------
+CompressedTrack::CompressedTrack( Track const & iTrack )
+	: m_size( iTrack.size() )
+{
+	ProfileScope const scope( "CompressedTrack" );
+	std::vector< int64_t > fixedX( m_size ), fixedY( m_size );
+	for( size_t i = 0; i < m_size; ++i ) {
+		fixedX[ i ] = std::llround( iTrack.x[ i ] * COORDINATE_UNITS );
+		fixedY[ i ] = std::llround( iTrack.y[ i ] * COORDINATE_UNITS );
+	}
+
+	m_blocks.reserve( ( m_size + BLOCK_SIZE - 1 ) / BLOCK_SIZE );
+	m_data.reserve( m_size * 6 ); // a typical 1 Hz track
+	for( size_t block = 0; block * BLOCK_SIZE < m_size; ++block ) {
+		size_t const begin = block * BLOCK_SIZE;
+		size_t const end = BlockEnd( block );
+		m_blocks.push_back( { m_data.size(), iTrack.time[ begin ], std::numeric_limits< double >::max(), std::numeric_limits< double >::lowest() } );
+		Block & index = m_blocks.back();
+
+		// bitmap of speeds calculated again by the decoder, the others follow their position
+		size_t const bitmap = m_data.size();
+		m_data.resize( m_data.size() + ( end - begin + 7 ) / 8, 0 );
+		int64_t time = 0, x = 0, y = 0;
+		for( size_t i = begin; i < end; ++i ) {
+			WriteDelta( int64_t( iTrack.time[ i ] ), time, m_data );
+			WriteDelta( fixedX[ i ], x, m_data );
+			WriteDelta( fixedY[ i ], y, m_data );
+
+			double speed = iTrack.speed[ i ];
+			bool derived = false;
+			if( i + 1 < m_size ) {
+				double const meters = SegmentMeters( Coordinate( fixedX[ i ] ), Coordinate( fixedY[ i ] ), Coordinate( fixedX[ i + 1 ] ), Coordinate( fixedY[ i + 1 ] ) );
+				double const nextSpeed = gpx::SegmentSpeed( meters, iTrack.time[ i ], iTrack.time[ i + 1 ] );
+				derived = std::fabs( nextSpeed - speed ) <= DERIVED_SPEED_TOLERANCE;
+				if( derived )
+					speed = nextSpeed;
+			}
+			if( derived ) {
+				m_data[ bitmap + ( i - begin ) / 8 ] |= uint8_t( 1 << ( ( i - begin ) % 8 ) );
+			} else {
+				int64_t zero = 0;
+				WriteDelta( std::llround( speed * SPEED_UNITS ), zero, m_data );
+				speed = std::llround( speed * SPEED_UNITS ) / SPEED_UNITS;
+			}
+			// the index keeps speeds as they are decoded
+			index.minSpeed = std::min( index.minSpeed, speed );
+			index.maxSpeed = std::max( index.maxSpeed, speed );
+		}
+	}
+	m_data.shrink_to_fit();
+}
+
+//-------------------------------------------------------------------------
+size_t CompressedTrack::MemoryUsage() const
+{
+	return m_data.capacity() + m_blocks.capacity() * sizeof( Block );
+}
+
+//-------------------------------------------------------------------------
+size_t CompressedTrack::BlockEnd( size_t iBlock ) const
+{
+	return std::min( ( iBlock + 1 ) * BLOCK_SIZE, m_size );
+}
+
+//-------------------------------------------------------------------------
+void CompressedTrack::DecodeFirst( size_t iBlock, Track & ioTrack ) const
+{
+	uint8_t const * data = m_data.data() + m_blocks[ iBlock ].offset + ( BlockEnd( iBlock ) - iBlock * BLOCK_SIZE + 7 ) / 8;
+	int64_t time = 0, x = 0, y = 0;
+	ReadDelta( data, time );
+	ReadDelta( data, x );
+	ReadDelta( data, y );
+	ioTrack.time.push_back( time_t( time ) );
+	ioTrack.x.push_back( Coordinate( x ) );
+	ioTrack.y.push_back( Coordinate( y ) );
+	ioTrack.speed.push_back( 0 );
+	ioTrack.distance.push_back( 0 );
+}
+
+//-------------------------------------------------------------------------
+void CompressedTrack::DecodeBlock( size_t iBlock, Track & ioTrack ) const
+{
+	size_t const count = BlockEnd( iBlock ) - iBlock * BLOCK_SIZE;
+	uint8_t const * const bitmap = m_data.data() + m_blocks[ iBlock ].offset;
+	uint8_t const * data = bitmap + ( count + 7 ) / 8;
+	size_t const first = ioTrack.size();
+	int64_t time = 0, x = 0, y = 0;
+	for( size_t i = 0; i < count; ++i ) {
+		ReadDelta( data, time );
+		ReadDelta( data, x );
+		ReadDelta( data, y );
+		int64_t speed = 0;
+		if( !( bitmap[ i / 8 ] & ( 1 << ( i % 8 ) ) ) )
+			ReadDelta( data, speed );
+		ioTrack.time.push_back( time_t( time ) );
+		ioTrack.x.push_back( Coordinate( x ) );
+		ioTrack.y.push_back( Coordinate( y ) );
+		ioTrack.speed.push_back( speed / SPEED_UNITS );
+	}
+
+	// distances to the next position, the last one goes to the next block, then the speeds which were not stored
+	bool const hasNext = iBlock + 1 < m_blocks.size();
+	if( hasNext )
+		DecodeFirst( iBlock + 1, ioTrack );
+	ioTrack.distance.resize( ioTrack.size(), 0 );
+	gpx::SegmentDistancesScalar( ioTrack.x.data() + first, ioTrack.y.data() + first, ioTrack.size() - first, ioTrack.distance.data() + first );
+	for( size_t i = 0; i < count; ++i )
+		if( bitmap[ i / 8 ] & ( 1 << ( i % 8 ) ) )
+			ioTrack.speed[ first + i ] = gpx::SegmentSpeed( ioTrack.distance[ first + i ], ioTrack.time[ first + i ], ioTrack.time[ first + i + 1 ] );
+	if( hasNext ) {
+		for( auto * column: { &ioTrack.x, &ioTrack.y, &ioTrack.speed, &ioTrack.distance } )
+			column->pop_back();
+		ioTrack.time.pop_back();
+	}
+}
+
+//-------------------------------------------------------------------------
+void CompressedTrack::Decode( size_t iBegin, size_t iEnd, Track & oTrack ) const
+{
+	oTrack.clear();
+	iEnd = std::min( iEnd, m_size );
+	if( iBegin >= iEnd )
+		return;
+
+	size_t const firstBlock = iBegin / BLOCK_SIZE;
+	size_t const lastBlock = ( iEnd - 1 ) / BLOCK_SIZE;
+	oTrack.reserve( ( lastBlock - firstBlock + 1 ) * BLOCK_SIZE + 1 );
+	oTrack.distance.reserve( ( lastBlock - firstBlock + 1 ) * BLOCK_SIZE + 1 );
+	for( size_t block = firstBlock; block <= lastBlock; ++block )
+		DecodeBlock( block, oTrack );
+
+	size_t const skip = iBegin - firstBlock * BLOCK_SIZE;
+	size_t const count = iEnd - iBegin;
+	for( auto * column: { &oTrack.x, &oTrack.y, &oTrack.speed, &oTrack.distance } ) {
+		column->erase( column->begin(), column->begin() + skip );
+		column->resize( count );
+	}
+	oTrack.time.erase( oTrack.time.begin(), oTrack.time.begin() + skip );
+	oTrack.time.resize( count );
+	oTrack.distance.back() = 0; // the cache has no distance after the last position
+}
+
+//-------------------------------------------------------------------------
+Track CompressedTrack::Decompress() const
+{
+	Track result;
+	Decode( 0, m_size, result );
+	return result;
+}
+
+//-------------------------------------------------------------------------
+size_t CompressedTrack::LowerBound( time_t iTime ) const
+{
+	// the answer is in the block before the first one starting not earlier than iTime, or it starts that block
+	auto const next = std::lower_bound( m_blocks.begin(), m_blocks.end(), iTime, []( Block const & iBlock, time_t iValue ) { return iBlock.firstTime < iValue; } );
+	if( next == m_blocks.begin() )
+		return 0;
+	size_t const block = size_t( next - m_blocks.begin() ) - 1;
+	Track decoded;
+	DecodeBlock( block, decoded );
+	auto const found = std::lower_bound( decoded.time.begin(), decoded.time.end(), iTime );
+	return block * BLOCK_SIZE + size_t( found - decoded.time.begin() );
+}
+
+//-------------------------------------------------------------------------
+void CompressedTrack::SpeedRange( size_t iBegin, size_t iEnd, double & oMin, double & oMax ) const
+{
+	oMin = std::numeric_limits< double >::max();
+	oMax = std::numeric_limits< double >::lowest();
+	Track decoded;
+	for( size_t block = iBegin / BLOCK_SIZE; block * BLOCK_SIZE < iEnd; ++block ) {
+		size_t const blockBegin = block * BLOCK_SIZE;
+		size_t const blockEnd = BlockEnd( block );
+		if( iBegin <= blockBegin && blockEnd <= iEnd ) {
+			oMin = std::min( oMin, m_blocks[ block ].minSpeed );
+			oMax = std::max( oMax, m_blocks[ block ].maxSpeed );
+			continue;
+		}
+		decoded.clear();
+		DecodeBlock( block, decoded );
+		for( size_t i = std::max( iBegin, blockBegin ); i < std::min( iEnd, blockEnd ); ++i ) {
+			oMin = std::min( oMin, decoded.speed[ i - blockBegin ] );
+			oMax = std::max( oMax, decoded.speed[ i - blockBegin ] );
+		}
+	}
+}
+
+//-------------------------------------------------------------------------
+bool CompressedTrack::CalculateInfo( float iSpeedLimit, TrackInfo & oInfo ) const
+{
+	ProfileScope const scope( "CompressedTrack::CalculateInfo" );
+	// segments of a block end at the first position of the next block, the summaries of blocks are appended
+	oInfo = TrackInfo();
+	oInfo.speedLimit = iSpeedLimit;
+	Track part;
+	for( size_t block = 0; block < m_blocks.size(); ++block ) {
+		part.clear();
+		DecodeBlock( block, part );
+		if( block + 1 < m_blocks.size() )
+			DecodeFirst( block + 1, part );
+		TrackInfo partInfo;
+		if( !partInfo.calculate( part, iSpeedLimit ) || !oInfo.append( partInfo ) )
+			return false;
+	}
+	if( oInfo.segmentCount == 0 )
+		return oInfo.calculate( part, iSpeedLimit ); // the sentinels of an empty summary
+	return true;
+}
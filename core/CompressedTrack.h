@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+struct Track;
+struct TrackInfo;
+
+/**
+ * @class CompressedTrack keeps a track in several times less memory than Track and decodes any part of it.
+ *
+ * Positions are stored in blocks of BLOCK_SIZE: time and longitude and latitude in 1e-7 degrees are written
+ * as zig-zag varint deltas from the previous position, the first position of a block from zero.
+ * A speed equal to the speed by the distance to the next position (all but stops after gaps and the last one
+ * after DefaultStages) is only marked in a bitmap of the block and calculated again, other speeds are written
+ * in 0.001 km/h. A block index (first time, byte offset, min and max speed of every block) finds the blocks
+ * of a time or index range, so a part is decoded without the rest of the track.
+ *
+ * Coordinates of GPX files (6 decimals usually) are kept exactly, distances are calculated from them
+ * by the scalar kernel. Extra columns are not kept.
+ */
+class CompressedTrack
+{
+public:
+	static size_t const BLOCK_SIZE = 256;
+
+	CompressedTrack() = default;
+	explicit CompressedTrack( Track const & iTrack );
+
+	size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	/// Bytes held by the encoded data and the block index.
+	size_t MemoryUsage() const;
+
+	/// Positions [ iBegin, iEnd ) to @a oTrack with the distance cache, whole blocks are decoded.
+	void Decode( size_t iBegin, size_t iEnd, Track & oTrack ) const;
+	Track Decompress() const;
+
+	/// Index of the first position not earlier than @a iTime, size() when there is none. Decodes one block.
+	size_t LowerBound( time_t iTime ) const;
+	/// Min and max speed of positions [ iBegin, iEnd ), iBegin < iEnd. Only the border blocks are decoded,
+	/// speeds of the blocks between are taken from the index.
+	void SpeedRange( size_t iBegin, size_t iEnd, double & oMin, double & oMax ) const;
+
+	/// The same result as TrackInfo::calculate of the decoded track, decodes one block at a time.
+	bool CalculateInfo( float iSpeedLimit, TrackInfo & oInfo ) const;
+
+private:
+	struct Block
+	{
+		size_t offset;   /// of the encoded block in m_data
+		time_t firstTime;
+		double minSpeed;
+		double maxSpeed;
+	};
+
+	/// Positions of block @a iBlock to the end of the columns of @a ioTrack, distances included:
+	/// the one of the last position goes to the first position of the next block.
+	void DecodeBlock( size_t iBlock, Track & ioTrack ) const;
+	/// Time and coordinates of the first position of block @a iBlock to the end of @a ioTrack, zero speed and distance.
+	void DecodeFirst( size_t iBlock, Track & ioTrack ) const;
+	size_t BlockEnd( size_t iBlock ) const;
+
+private:
+	size_t                 m_size = 0;
+	std::vector< uint8_t > m_data;   /// encoded blocks one after another
+	std::vector< Block >   m_blocks;
+};
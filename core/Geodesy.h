@@ -0,0 +1,121 @@
+#pragma once
+
+#include <math.h>
+#include <algorithm>
+
+// Earth model constants and helpers shared by distance computations.
+
+double const PI = 3.141592653589793;
+double const PI_FACTOR = PI / 180.0;
+double const MERIDIAN_LEN = 40007860.; // Meridian length in meters.
+double const EQUATOR_LEN = 40075696.; // Equator length in meters.
+double const ONE_METER = 360.0 / MERIDIAN_LEN; // in Y-degrees (~9e-6)
+
+inline double CosLatitude( double iLatitude ) {
+	return ::cos( iLatitude * PI_FACTOR );
+}
+
+inline double YDegreesToMeters( double iYDeg ) {
+	double const res = iYDeg / ONE_METER;
+	return res > 0 ? res : 0;
+}
+
+/**
+ * Geodesic policies: the distance in meters between two positions given as longitude and latitude in degrees,
+ * static double Meters( double iX, double iY, double iNextX, double iNextY ).
+ *
+ * A policy is a template argument (Position::DistanceInKM, Position::CalculateSpeedByNext, SpeedStage, TrackInfo::calculate),
+ * so the chosen formula is inlined into the loop without a virtual call or a branch.
+ * Equirectangular is the default and the only formula of the distance cache (SegmentKernels.h).
+ */
+namespace gpx
+{
+	double const EARTH_RADIUS = MERIDIAN_LEN / ( 2 * PI ); // of the sphere with the meridian of MERIDIAN_LEN, in meters
+	double const WGS84_A = 6378137.0;                      // semi-major axis of the WGS-84 ellipsoid, in meters
+	double const WGS84_F = 1 / 298.257223563;              // flattening of the WGS-84 ellipsoid
+	int const VINCENTY_ITERATIONS = 100;
+
+	/// Plane with cosine of the mean latitude: the fastest, good for the seconds between GPS fixes,
+	/// the error grows with the length of a segment and near the poles.
+	struct Equirectangular
+	{
+		static double Meters( double iX, double iY, double iNextX, double iNextY ) {
+			double const dx = ( iX - iNextX ) * CosLatitude( ( iY + iNextY ) / 2 );
+			double const dy = iY - iNextY;
+			return YDegreesToMeters( ::sqrt( dx * dx + dy * dy ) );
+		}
+	};
+
+	/// Great circle of the sphere of EARTH_RADIUS: exact for any length on the sphere, which differs from
+	/// the ellipsoid by up to 0.5%.
+	struct Haversine
+	{
+		static double Meters( double iX, double iY, double iNextX, double iNextY ) {
+			double const sinHalfY = ::sin( ( iNextY - iY ) * PI_FACTOR / 2 );
+			double const sinHalfX = ::sin( ( iNextX - iX ) * PI_FACTOR / 2 );
+			double const h = sinHalfY * sinHalfY + CosLatitude( iY ) * CosLatitude( iNextY ) * sinHalfX * sinHalfX;
+			return 2 * EARTH_RADIUS * ::asin( std::min( 1.0, ::sqrt( h ) ) );
+		}
+	};
+
+	/// Vincenty's inverse formula on the WGS-84 ellipsoid: millimeter accuracy, several times slower than Haversine.
+	/// Nearly antipodal points, for which the iterations don't converge, get the Haversine distance.
+	struct Vincenty
+	{
+		static double Meters( double iX, double iY, double iNextX, double iNextY ) {
+			double const b = WGS84_A * ( 1 - WGS84_F );
+			double const l = ( iNextX - iX ) * PI_FACTOR;
+			double const u1 = ::atan( ( 1 - WGS84_F ) * ::tan( iY * PI_FACTOR ) );
+			double const u2 = ::atan( ( 1 - WGS84_F ) * ::tan( iNextY * PI_FACTOR ) );
+			double const sinU1 = ::sin( u1 ), cosU1 = ::cos( u1 );
+			double const sinU2 = ::sin( u2 ), cosU2 = ::cos( u2 );
+
+			double lambda = l;
+			for( int i = 0; i < VINCENTY_ITERATIONS; ++i ) {
+				double const sinLambda = ::sin( lambda ), cosLambda = ::cos( lambda );
+				double const crossA = cosU2 * sinLambda;
+				double const crossB = cosU1 * sinU2 - sinU1 * cosU2 * cosLambda;
+				double const sinSigma = ::sqrt( crossA * crossA + crossB * crossB );
+				if( sinSigma == 0 )
+					return 0; // the same point
+				double const cosSigma = sinU1 * sinU2 + cosU1 * cosU2 * cosLambda;
+				double const sigma = ::atan2( sinSigma, cosSigma );
+				double const sinAlpha = cosU1 * cosU2 * sinLambda / sinSigma;
+				double const cos2Alpha = 1 - sinAlpha * sinAlpha;
+				double const cos2SigmaM = cos2Alpha != 0 ? cosSigma - 2 * sinU1 * sinU2 / cos2Alpha : 0; // 0 on the equator
+				double const c = WGS84_F / 16 * cos2Alpha * ( 4 + WGS84_F * ( 4 - 3 * cos2Alpha ) );
+				double const previous = lambda;
+				lambda = l + ( 1 - c ) * WGS84_F * sinAlpha *
+						( sigma + c * sinSigma * ( cos2SigmaM + c * cosSigma * ( -1 + 2 * cos2SigmaM * cos2SigmaM ) ) );
+				if( ::fabs( lambda - previous ) > 1e-12 )
+					continue;
+
+				double const uu = cos2Alpha * ( WGS84_A * WGS84_A - b * b ) / ( b * b );
+				double const aa = 1 + uu / 16384 * ( 4096 + uu * ( -768 + uu * ( 320 - 175 * uu ) ) );
+				double const bb = uu / 1024 * ( 256 + uu * ( -128 + uu * ( 74 - 47 * uu ) ) );
+				double const deltaSigma = bb * sinSigma * ( cos2SigmaM + bb / 4 * ( cosSigma * ( -1 + 2 * cos2SigmaM * cos2SigmaM ) -
+						bb / 6 * cos2SigmaM * ( -3 + 4 * sinSigma * sinSigma ) * ( -3 + 4 * cos2SigmaM * cos2SigmaM ) ) );
+				return b * aa * ( sigma - deltaSigma );
+			}
+			return Haversine::Meters( iX, iY, iNextX, iNextY );
+		}
+	};
+
+	/// A policy chosen at runtime, e.g. by ReadOptions::geodesic.
+	enum class EGeodesic { Equirectangular, Haversine, Vincenty };
+
+	/// Calls @a iFunction with an instance of the policy @a iGeodesic, so the formula is still a template argument
+	/// of the code called by it: WithGeodesic( geodesic, []( auto iPolicy ) { return F< decltype( iPolicy ) >(); } ).
+	template< typename TFunction >
+	decltype( auto ) WithGeodesic( EGeodesic iGeodesic, TFunction const & iFunction ) {
+		switch( iGeodesic ) {
+		case EGeodesic::Haversine:
+			return iFunction( Haversine() );
+		case EGeodesic::Vincenty:
+			return iFunction( Vincenty() );
+		case EGeodesic::Equirectangular:
+			break;
+		}
+		return iFunction( Equirectangular() );
+	}
+}
@@ -0,0 +1,132 @@
+#include <string.h>
+#include "IsoTimeDecoder.h"
+
+namespace
+{
+	size_t const DATE_LEN = 10;     // YYYY-MM-DD
+	size_t const DATE_TIME_LEN = 19; // YYYY-MM-DDTHH:MM:SS
+
+	inline bool IsDigit( char iChar ) {
+		return iChar >= '0' && iChar <= '9';
+	}
+
+	/// Reads iCount digits at iPos, false when there is no digit.
+	inline bool ReadNumber( std::string_view iStr, size_t iPos, size_t iCount, int & oValue ) {
+		oValue = 0;
+		for( size_t i = iPos; i < iPos + iCount; ++i ) {
+			if( !IsDigit( iStr[ i ] ) )
+				return false;
+			oValue = oValue * 10 + ( iStr[ i ] - '0' );
+		}
+		return true;
+	}
+
+	/// Seconds since midnight of "HH:MM:SS" at iPos (any separators), -1 for a wrong format.
+	inline long ReadDayTime( std::string_view iStr, size_t iPos ) {
+		int hour, minute, second;
+		if( !ReadNumber( iStr, iPos, 2, hour ) || !ReadNumber( iStr, iPos + 3, 2, minute ) || !ReadNumber( iStr, iPos + 6, 2, second ) )
+			return -1;
+		if( hour > 23 || minute > 59 || second > 60 ) // 60 is a leap second
+			return -1;
+		return hour * 3600L + minute * 60L + second;
+	}
+}
+
+//-------------------------------------------------------------------------
+long IsoTimeDecoder::DaysFromCivil( int iYear, int iMonth, int iDay )
+{
+	// http://howardhinnant.github.io/date_algorithms.html#days_from_civil
+	long const year = iYear - ( iMonth <= 2 );
+	long const era = ( year >= 0 ? year : year - 399 ) / 400;
+	long const yearOfEra = year - era * 400;
+	long const dayOfYear = ( 153 * ( iMonth + ( iMonth > 2 ? -3 : 9 ) ) + 2 ) / 5 + iDay - 1;
+	long const dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+	return era * 146097 + dayOfEra - 719468;
+}
+
+//-------------------------------------------------------------------------
+bool IsoTimeDecoder::DecodeDate( std::string_view iDate, time_t & oDayStart )
+{
+	if( m_cachedDayStart != 0 && ::memcmp( iDate.data(), m_cachedDate, DATE_LEN ) == 0 ) {
+		oDayStart = m_cachedDayStart;
+		return true;
+	}
+
+	int year, month, day;
+	if( !ReadNumber( iDate, 0, 4, year ) || !ReadNumber( iDate, 5, 2, month ) || !ReadNumber( iDate, 8, 2, day ) )
+		return false;
+	if( month < 1 || month > 12 || day < 1 || day > 31 )
+		return false;
+
+	oDayStart = time_t( DaysFromCivil( year, month, day ) ) * 86400;
+	::memcpy( m_cachedDate, iDate.data(), DATE_LEN );
+	m_cachedDayStart = oDayStart; // 0 for 1970-01-01 means it is never cached, it's not a problem
+	return true;
+}
+
+//-------------------------------------------------------------------------
+time_t IsoTimeDecoder::Decode( std::string_view iDateTime )
+{
+	// Fast path: YYYY-MM-DDTHH:MM:SSZ
+	if( iDateTime.size() != DATE_TIME_LEN + 1 || iDateTime.back() != 'Z' )
+		return DecodeGeneric( iDateTime );
+
+	time_t dayStart;
+	if( !DecodeDate( iDateTime, dayStart ) )
+		return 0;
+	long const dayTime = ReadDayTime( iDateTime, DATE_LEN + 1 );
+	if( dayTime < 0 )
+		return 0;
+	return dayStart + dayTime;
+}
+
+//-------------------------------------------------------------------------
+time_t IsoTimeDecoder::DecodeGeneric( std::string_view iDateTime )
+{
+	// YYYY-MM-DDTHH:MM:SS[.fraction][Z|+HH:MM|-HH:MM|+HHMM|-HHMM|+HH|-HH], no zone means UTC.
+	if( iDateTime.size() < DATE_TIME_LEN )
+		return 0;
+
+	time_t dayStart;
+	if( !DecodeDate( iDateTime, dayStart ) )
+		return 0;
+	long const dayTime = ReadDayTime( iDateTime, DATE_LEN + 1 );
+	if( dayTime < 0 )
+		return 0;
+
+	std::string_view zone = iDateTime.substr( DATE_TIME_LEN );
+	if( !zone.empty() && ( zone[ 0 ] == '.' || zone[ 0 ] == ',' ) ) {
+		size_t digits = 1;
+		while( digits < zone.size() && IsDigit( zone[ digits ] ) )
+			++digits;
+		if( digits == 1 )
+			return 0;
+		zone.remove_prefix( digits ); // fraction of a second is truncated
+	}
+
+	long offset = 0;
+	if( zone.empty() || zone == "Z" ) {
+		offset = 0;
+	} else if( zone[ 0 ] == '+' || zone[ 0 ] == '-' ) {
+		int hours = 0, minutes = 0;
+		if( zone.size() == 3 ) {
+			if( !ReadNumber( zone, 1, 2, hours ) )
+				return 0;
+		} else if( zone.size() == 5 ) {
+			if( !ReadNumber( zone, 1, 2, hours ) || !ReadNumber( zone, 3, 2, minutes ) )
+				return 0;
+		} else if( zone.size() == 6 && zone[ 3 ] == ':' ) {
+			if( !ReadNumber( zone, 1, 2, hours ) || !ReadNumber( zone, 4, 2, minutes ) )
+				return 0;
+		} else {
+			return 0;
+		}
+		if( hours > 23 || minutes > 59 )
+			return 0;
+		offset = ( hours * 3600L + minutes * 60L ) * ( zone[ 0 ] == '+' ? 1 : -1 );
+	} else {
+		return 0;
+	}
+
+	return dayStart + dayTime - offset; // local time = UTC + offset
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <time.h>
+#include <string_view>
+
+/**
+ * @class IsoTimeDecoder converts ISO-8601 date-time like "2017-05-10T22:26:42Z" to UTC epoch seconds.
+ *
+ * The 20 symbols UTC form is decoded by a fixed-format fast path. The epoch of the last decoded day
+ * is cached, so consecutive positions of the same date cost a few integer operations.
+ * Fractional seconds (truncated) and "+HH:MM" / "-HH:MM" offsets are decoded by a slower path.
+ * The decoder doesn't touch the libc time zone state; use one instance per thread.
+ */
+class IsoTimeDecoder
+{
+public:
+	/// Returns 0 when @a iDateTime is not a valid date-time.
+	time_t Decode( std::string_view iDateTime );
+
+	/// Days since 1970-01-01 of the proleptic Gregorian date.
+	static long DaysFromCivil( int iYear, int iMonth, int iDay );
+
+private:
+	time_t DecodeGeneric( std::string_view iDateTime );
+	bool   DecodeDate( std::string_view iDate, time_t & oDayStart );
+
+private:
+	char   m_cachedDate[ 10 ] = {}; /// "YYYY-MM-DD" part of the last decoded string
+	time_t m_cachedDayStart = 0;    /// epoch of m_cachedDate midnight, 0 when nothing is cached
+};
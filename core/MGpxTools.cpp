@@ -0,0 +1,854 @@
+#include <math.h>
+#include <string.h>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <time.h>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <type_traits>
+#include "MGpxTools.h"
+#include "Track.h"
+#include "Geodesy.h"
+#include "SegmentKernels.h"
+#include "MappedFile.h"
+#include "CompressedInput.h"
+#include "IsoTimeDecoder.h"
+#include "TrackCache.h"
+#include "Profiler.h"
+#include "ThreadPool.h"
+
+char const * const GPX_HEADER_MASK = "<?xml version=\"1.0\"?>\n"
+	"<gpx version=\"1.0\" creator=\"JamServer\" xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
+	"xmlns=\"http://www.topografix.com/GPX/1/0\" xsi:schemaLocation=\"http://www.topografix.com/GPX/1/0 "
+	"http://www.topografix.com/GPX/1/0/gpx.xsd\">\n";
+
+char const * const GPX_TIME_MASK = "<time>%04d-%02d-%02dT%02d:%02d:%02dZ</time>";
+char const * const GPX_HDOP_MASK = "<hdop>%d</hdop>";
+char const * const GPX_POS_HEAD_AND_POINT_MASK = "      <trkpt lat=\"%.6f\" lon=\"%.6f\">";
+
+char const * const GPX_POS_DESC_MASK = "<desc>mcc: %u, mnc: %u, lac: %u, cid: %u, ss: -%u, ta: %u</desc>";
+char const * const GPX_POS_TAIL = "</trkpt>\n";
+
+char const * const GPX_TRACK_HEAD = "  <trk><name>Track</name>\n    <trkseg>\n";
+char const * const GPX_TRACK_TAIL = "    </trkseg>\n  </trk>\n";
+
+char const * const GPX_TAIL = "</gpx>";
+
+size_t const STREAM_CHUNK_SIZE = 1 << 20; // bytes read from a stream at once
+size_t const MIN_BYTES_PER_THREAD = 4 << 20; // smaller files are parsed by a single thread
+size_t const PROGRESS_POSITIONS = 1 << 12; // progress is reported and cancellation is polled once per that many positions
+// --------------------------------------------------------------------------------------
+std::string_view const WHITE_SPACE_CHARS = " \n\r\t\v\f";
+
+//-------------------------------------------------------------------------
+inline std::string_view Trim( std::string_view iStr )
+{
+	size_t const first = iStr.find_first_not_of( WHITE_SPACE_CHARS );
+	if( first == std::string_view::npos )
+		return std::string_view();
+	size_t const last = iStr.find_last_not_of( WHITE_SPACE_CHARS );
+	return iStr.substr( first, last - first + 1 );
+}
+
+//-------------------------------------------------------------------------
+/// Position of the first @a iChar at or after @a iFrom, npos when there is none.
+inline size_t FindChar( std::string_view iData, size_t iFrom, char iChar )
+{
+	if( iFrom >= iData.size() )
+		return std::string_view::npos;
+	void const * const found = ::memchr( iData.data() + iFrom, iChar, iData.size() - iFrom );
+	return found ? static_cast< char const * >( found ) - iData.data() : std::string_view::npos;
+}
+
+//-------------------------------------------------------------------------
+/// Position of the first @a iToken at or after @a iFrom, npos when there is none.
+inline size_t FindToken( std::string_view iData, size_t iFrom, std::string_view iToken )
+{
+	// memchr on the first symbol is much faster than the generic search for short tokens
+	for( size_t pos = FindChar( iData, iFrom, iToken[ 0 ] ); pos != std::string_view::npos; pos = FindChar( iData, pos + 1, iToken[ 0 ] ) )
+		if( iData.compare( pos, iToken.size(), iToken ) == 0 )
+			return pos;
+	return std::string_view::npos;
+}
+
+//-------------------------------------------------------------------------
+/// Locale independent replacement of std::stod, skips leading spaces like strtod does.
+inline bool StringToDouble( std::string_view iStr, double & oValue )
+{
+	iStr = Trim( iStr );
+	if( !iStr.empty() && iStr[ 0 ] == '+' )
+		iStr.remove_prefix( 1 );
+	std::from_chars_result const res = std::from_chars( iStr.data(), iStr.data() + iStr.size(), oValue );
+	return res.ec == std::errc();
+}
+
+//-------------------------------------------------------------------------
+/// Values of the optional fields of one position, NaN when its <trkpt> has no such tag.
+typedef std::array< double, gpx::FIELD_COUNT > TFieldValues;
+int const TAG_TIME = gpx::FIELD_COUNT;
+int const TAG_UNKNOWN = gpx::FIELD_COUNT + 1;
+
+/// gpx::EField, TAG_TIME or TAG_UNKNOWN for the name of a <trkpt> child. Dispatched by the length first,
+/// so any tag costs a jump and at most two short comparisons.
+inline int TagField( std::string_view iName )
+{
+	switch( iName.size() ) {
+	case 3: return iName == "ele" ? gpx::FIELD_ELEVATION : iName == "sat" ? gpx::FIELD_SATELLITES : TAG_UNKNOWN;
+	case 4: return iName == "time" ? TAG_TIME : iName == "hdop" ? gpx::FIELD_HDOP : TAG_UNKNOWN;
+	case 5: return iName == "speed" ? gpx::FIELD_SPEED : TAG_UNKNOWN;
+	case 6: return iName == "course" ? gpx::FIELD_COURSE : TAG_UNKNOWN;
+	default: return TAG_UNKNOWN;
+	}
+}
+
+// --------------------------------------------------------------------------------------
+/**
+ * @class MParserGPX is tool class for parsing a .gpx file.
+ *
+ * The parser walks the buffer forward only once: every <trkpt> element is tokenized in place
+ * with string views, so nothing is copied or allocated per position. Children of <trkpt> are recognized
+ * by TagField(), the values of the requested fields are parsed in place and unknown tags are only skipped.
+ * A stream is read by chunks of STREAM_CHUNK_SIZE bytes, consumed data is dropped from the buffer,
+ * so memory doesn't depend on the stream size and the stream doesn't need to be seekable.
+ */
+class MParserGPX
+{
+public:
+	/// @a iFields - bits ( 1 << gpx::EField ) of the fields returned by GetNextTrackPos().
+	MParserGPX( std::istream & iStream, unsigned iFields = 0 );
+	explicit MParserGPX( std::string_view iData, unsigned iFields = 0 );
+	~MParserGPX();
+	MParserGPX( MParserGPX const & ) = delete; // m_data may point into m_buffer
+	MParserGPX & operator=( MParserGPX const & ) = delete;
+
+	/// @a oFields gets the requested fields of the position, others are NaN.
+	bool GetNextTrackPos( Position & oPos, TFieldValues * oFields = nullptr );
+	/// Bytes of the input consumed so far.
+	size_t Offset() const { return m_dropped + m_readingIndex; }
+
+private: // helpers
+	bool ReadDoubleAttribute( std::string_view iHead, std::string_view iName, double & oValue ) const;
+	bool ReadSimpleTags( size_t iReadingIndex, std::string_view & oTime, bool & oTimeFound );
+
+	bool ReadNextChunk( size_t iKeepFrom );
+
+private: // members
+	time_t           m_lastPosTime;  /// time of the last position
+	IsoTimeDecoder   m_timeDecoder;  /// <time> values decoder, caches the current day
+	Position         m_next;         /// position to be parsed
+	unsigned const   m_fields;       /// bits of the fields to parse
+	TFieldValues     m_nextFields;   /// fields of m_next
+	size_t           m_readingIndex; /// position of read index in m_data
+	std::istream *   m_stream;       /// source of data, nullptr when whole data is in memory
+	size_t           m_dropped;      /// bytes of the stream dropped from m_buffer
+	std::string      m_buffer;       /// unparsed part of the stream data
+	std::string_view m_data;         /// buffer being parsed
+	bool const       m_profile;      /// Profiler was enabled at start, reading, tag scan and time decoding are timed
+	uint64_t         m_counters[ Profiler::COUNTER_COUNT ] = {}; /// added to Profiler at the end
+};
+
+//-------------------------------------------------------------------------
+MParserGPX::MParserGPX( std::istream & iStream, unsigned iFields )
+	: m_lastPosTime( 0 )
+	, m_fields( iFields )
+	, m_readingIndex( 0 )
+	, m_stream( &iStream )
+	, m_dropped( 0 )
+	, m_profile( Profiler::IsEnabled() )
+{
+	ReadNextChunk( 0 );
+}
+
+//-------------------------------------------------------------------------
+MParserGPX::MParserGPX( std::string_view iData, unsigned iFields )
+	: m_lastPosTime( 0 )
+	, m_fields( iFields )
+	, m_readingIndex( 0 )
+	, m_stream( nullptr )
+	, m_dropped( 0 )
+	, m_data( iData )
+	, m_profile( Profiler::IsEnabled() )
+{
+}
+
+//-------------------------------------------------------------------------
+MParserGPX::~MParserGPX()
+{
+	for( int i = 0; i < Profiler::COUNTER_COUNT; ++i )
+		Profiler::Add( Profiler::ECounter( i ), m_counters[ i ] );
+}
+
+//-------------------------------------------------------------------------
+bool MParserGPX::ReadNextChunk( size_t iKeepFrom )
+{
+	// Drops data before iKeepFrom and appends the next chunk of the stream, false at the end of data.
+	if( m_stream == nullptr || !*m_stream )
+		return false;
+
+	m_buffer.erase( 0, iKeepFrom );
+	m_dropped += iKeepFrom;
+	m_readingIndex = m_readingIndex > iKeepFrom ? m_readingIndex - iKeepFrom : 0;
+
+	size_t const kept = m_buffer.size();
+	m_buffer.resize( kept + STREAM_CHUNK_SIZE );
+	int64_t const readStart = m_profile ? Profiler::Now() : 0;
+	m_stream->read( &m_buffer[ kept ], STREAM_CHUNK_SIZE );
+	if( m_profile )
+		m_counters[ Profiler::StreamReadNs ] += Profiler::Now() - readStart;
+	size_t const read = size_t( m_stream->gcount() );
+	m_buffer.resize( kept + read );
+	m_data = m_buffer;
+
+	if( m_stream->bad() )
+		throw std::runtime_error( "MParserGPX: Error reading a stream" );
+	return read > 0;
+}
+
+//-------------------------------------------------------------------------
+bool MParserGPX::ReadSimpleTags( size_t iReadingIndex, std::string_view & oTime, bool & oTimeFound )
+{
+	// Reads all tags before </trkpt> is met and leaves m_readingIndex behind it.
+	// <tagname>value</tagname>, the value of <time> and the ones of the fields in m_fields are needed.
+	// Returns false when the data ends before </trkpt>.
+	static std::string_view const CLOSING_TRACKPT = "</trkpt";
+	oTimeFound = false;
+	m_nextFields.fill( NAN );
+	size_t index = iReadingIndex;
+
+	while( true )
+	{
+		size_t const tagStart = FindChar( m_data, index, '<' );
+		if( tagStart == std::string_view::npos )
+			break;
+
+		index = tagStart + 1;
+		if( tagStart + CLOSING_TRACKPT.size() > m_data.size() )
+			break; // can't say if it is the closing tag
+		if( m_data.compare( tagStart, CLOSING_TRACKPT.size(), CLOSING_TRACKPT ) == 0 )
+		{
+			m_readingIndex = index;
+			return true;
+		}
+		if( index < m_data.size() && m_data[ index ] == '/' )
+			continue;
+
+		size_t const tagEnd = FindChar( m_data, index, '>' );
+		if( tagEnd == std::string_view::npos )
+			break;
+
+		std::string_view const name = Trim( m_data.substr( index, tagEnd - index ) );
+		index = tagEnd + 1;
+		size_t const valueEnd = FindChar( m_data, index, '<' );
+		int const field = TagField( name );
+		if( field == TAG_TIME )
+		{
+			oTime = Trim( m_data.substr( index, valueEnd - index ) ); // valueEnd may be npos, it's ok for substr
+			oTimeFound = true;
+		}
+		else if( field != TAG_UNKNOWN && ( m_fields & ( 1u << field ) ) )
+		{
+			double value = 0;
+			if( StringToDouble( m_data.substr( index, valueEnd - index ), value ) )
+				m_nextFields[ field ] = value;
+		}
+	}
+
+	m_readingIndex = m_data.size();
+	return false;
+}
+
+//-------------------------------------------------------------------------
+bool MParserGPX::ReadDoubleAttribute( std::string_view iHead, std::string_view iName, double & oValue ) const
+{
+	// Format is the following: <trkpt lat="55.743412" lon="37.533829">, iHead is the part between "<trkpt" and ">"
+	size_t const name = iHead.find( iName ); // name = lat, lon
+	if( name == std::string_view::npos )
+		return false;
+
+	size_t const start = FindChar( iHead, name + iName.size(), '"' );
+	if( start == std::string_view::npos )
+		return false;
+
+	size_t const end = FindChar( iHead, start + 1, '"' );
+	if( end == std::string_view::npos )
+		return false;
+
+	return StringToDouble( iHead.substr( start + 1, end - start - 1 ), oValue );
+}
+
+//-------------------------------------------------------------------------
+bool MParserGPX::GetNextTrackPos( Position & oPos, TFieldValues * oFields )
+{
+	static std::string_view const OPENING_TRACKPT = "<trkpt";
+	oPos = Position();
+
+	std::string_view content;
+	bool timeFound = false;
+
+	while( true )
+	{
+		size_t const pointStart = FindToken( m_data, m_readingIndex, OPENING_TRACKPT );
+		if( pointStart == std::string_view::npos )
+		{
+			// the tail may be the beginning of the token cut by the chunk border
+			size_t const tail = std::min( m_data.size(), OPENING_TRACKPT.size() - 1 );
+			if( this->ReadNextChunk( std::max( m_readingIndex, m_data.size() - tail ) ) )
+				continue;
+			m_readingIndex = m_data.size();
+			return false; // the end of a track reached
+		}
+
+		m_readingIndex = pointStart + OPENING_TRACKPT.size();
+		size_t const headEnd = FindChar( m_data, m_readingIndex, '>' );
+		if( headEnd == std::string_view::npos )
+		{
+			m_readingIndex = pointStart;
+			if( this->ReadNextChunk( pointStart ) )
+				continue; // the element is cut by the chunk border, parse it again
+			m_readingIndex = m_data.size();
+			return false; // truncated file
+		}
+
+		std::string_view const head = m_data.substr( m_readingIndex, headEnd - m_readingIndex );
+		if( ( !this->ReadDoubleAttribute( head, "lon", m_next.x ) ) ||
+				( !this->ReadDoubleAttribute( head, "lat", m_next.y ) ) )
+		{
+			++m_counters[ Profiler::SkippedNoCoordinates ];
+			continue; // skip position without coordinates
+		}
+
+		int64_t const scanStart = m_profile ? Profiler::Now() : 0;
+		bool const complete = this->ReadSimpleTags( headEnd + 1, content, timeFound );
+		if( m_profile )
+			m_counters[ Profiler::TagScanNs ] += Profiler::Now() - scanStart;
+		if( !complete )
+		{
+			size_t const readingIndex = m_readingIndex;
+			m_readingIndex = pointStart;
+			if( this->ReadNextChunk( pointStart ) )
+				continue; // the element is cut by the chunk border, parse it again
+			m_readingIndex = readingIndex;
+		}
+
+		if( !timeFound )
+		{
+			++m_counters[ Profiler::SkippedNoTime ];
+			continue; // skip position without time
+		}
+
+		int64_t const decodeStart = m_profile ? Profiler::Now() : 0;
+		m_next.time = m_timeDecoder.Decode( content );
+		if( m_profile )
+			m_counters[ Profiler::TimeDecodeNs ] += Profiler::Now() - decodeStart;
+
+		if( m_next.time == 0 ) // skip position with incorrect time or wrong time field format
+		{
+			++m_counters[ Profiler::SkippedBadTime ];
+			continue;
+		}
+
+		if( m_next.time <= m_lastPosTime ) // non-chronological positions -> skip it
+		{
+			++m_counters[ Profiler::SkippedNonChronological ];
+			continue;
+		}
+
+		break;
+	}
+
+	m_lastPosTime = m_next.time;
+	oPos = m_next;
+	if( oFields )
+		*oFields = m_nextFields;
+	return true;
+}
+
+// --------------------------------------------------------------------------------------
+/**
+ * @class ReadProgress counts parsed bytes of one reading, reports them and polls its cancellation.
+ *
+ * Shared by all threads parsing the data, ReadOptions::progress is called by one thread at a time
+ * and never with a smaller value than before.
+ */
+class ReadProgress
+{
+public:
+	ReadProgress( gpx::ReadOptions const & iOptions, size_t iTotal );
+
+	/// Adds parsed bytes, throws gpx::ReadCancelled when the reading is cancelled.
+	void Advance( size_t iBytes );
+	/// Reports all parsed bytes, even when another thread is reporting now.
+	void Finish();
+
+private:
+	void Report( size_t iRead );
+
+private:
+	gpx::ReadOptions const & m_options;
+	size_t const             m_total;        /// size of the data, 0 when unknown
+	std::atomic< size_t >    m_read;         /// bytes parsed by all threads
+	std::mutex               m_reportMutex;  /// serializes calls of m_options.progress
+	size_t                   m_reported;     /// the last reported value, guarded by m_reportMutex
+};
+
+//-------------------------------------------------------------------------
+ReadProgress::ReadProgress( gpx::ReadOptions const & iOptions, size_t iTotal )
+	: m_options( iOptions )
+	, m_total( iTotal )
+	, m_read( 0 )
+	, m_reported( 0 )
+{
+}
+
+//-------------------------------------------------------------------------
+void ReadProgress::Advance( size_t iBytes )
+{
+	size_t const read = m_read.fetch_add( iBytes, std::memory_order_relaxed ) + iBytes;
+	if( m_options.isCancelled && m_options.isCancelled() )
+		throw gpx::ReadCancelled();
+
+	if( !m_options.progress )
+		return;
+	std::unique_lock< std::mutex > lock( m_reportMutex, std::try_to_lock );
+	if( lock )
+		Report( read ); // skip the report when another thread is reporting, Finish() reports the rest
+}
+
+//-------------------------------------------------------------------------
+void ReadProgress::Finish()
+{
+	if( !m_options.progress )
+		return;
+	std::lock_guard< std::mutex > lock( m_reportMutex );
+	Report( m_read.load( std::memory_order_relaxed ) );
+}
+
+//-------------------------------------------------------------------------
+void ReadProgress::Report( size_t iRead )
+{
+	if( iRead <= m_reported )
+		return;
+	m_reported = iRead;
+	m_options.progress( iRead, m_total );
+}
+
+//-------------------------------------------------------------------------
+/// Positions parsed in the order of the file and their fields, one per position when requested.
+struct RawPositions
+{
+	std::vector< Position >     positions;
+	std::vector< TFieldValues > fields;
+	size_t                      gapCount = 0; /// pauses longer than the gap time between the positions
+};
+
+/// Bits of the fields to be parsed for @a iOptions.
+inline unsigned ParsedFields( gpx::ReadOptions const & iOptions )
+{
+	return iOptions.fields | ( iOptions.deviceSpeed ? 1u << gpx::FIELD_SPEED : 0u );
+}
+
+//-------------------------------------------------------------------------
+void ReadRawPositions( MParserGPX & ioParser, ReadProgress & ioProgress, bool iWithFields, time_t iGapTime, RawPositions & oRaw )
+{
+	ProfileScope const scope( "Parse" );
+	std::vector< Position > & oPositions = oRaw.positions;
+	Position pi;
+	TFieldValues fields;
+	size_t reported = 0;
+
+	while( ioParser.GetNextTrackPos( pi, iWithFields ? &fields : nullptr ) ) {
+		if( !oPositions.empty() && pi.time - oPositions.back().time > iGapTime )
+			++oRaw.gapCount;
+		oPositions.push_back( pi );
+		if( iWithFields )
+			oRaw.fields.push_back( fields );
+		if( oPositions.size() % PROGRESS_POSITIONS == 0 ) {
+			size_t const offset = ioParser.Offset();
+			ioProgress.Advance( offset - reported );
+			reported = offset;
+		}
+	}
+	ioProgress.Advance( ioParser.Offset() - reported );
+}
+
+//-------------------------------------------------------------------------
+/// Pool of the readings without ReadOptions::threadPool, started by the first of them.
+ThreadPool & SharedReadPool()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+//-------------------------------------------------------------------------
+void ReadRawPositionsParallel( std::string_view iData, unsigned iThreadCount, unsigned iFields, time_t iGapTime, ThreadPool & ioPool,
+		ReadProgress & ioProgress, RawPositions & oRaw )
+{
+	// Chunks start at "<trkpt", so every chunk is a valid input for a separate parser.
+	static std::string_view const OPENING_TRACKPT = "<trkpt";
+	std::vector< size_t > borders( 1, 0 );
+	for( unsigned i = 1; i < iThreadCount; ++i ) {
+		size_t const pos = FindToken( iData, std::max( borders.back() + 1, iData.size() / iThreadCount * i ), OPENING_TRACKPT );
+		if( pos == std::string_view::npos )
+			break;
+		borders.push_back( pos );
+	}
+	borders.push_back( iData.size() );
+
+	size_t const chunkCount = borders.size() - 1;
+	std::vector< RawPositions > chunks( chunkCount );
+	std::vector< std::exception_ptr > errors( chunkCount );
+	auto const parseChunk = [&]( size_t iChunk ) {
+		try {
+			MParserGPX parserGpx( iData.substr( borders[ iChunk ], borders[ iChunk + 1 ] - borders[ iChunk ] ), iFields );
+			ReadRawPositions( parserGpx, ioProgress, iFields != 0, iGapTime, chunks[ iChunk ] );
+		} catch( ... ) {
+			errors[ iChunk ] = std::current_exception();
+		}
+	};
+
+	// not Wait: the pool may be busy with other work or run the caller
+	ioPool.ForEach( chunkCount, parseChunk );
+	for( std::exception_ptr const & error: errors )
+		if( error )
+			std::rethrow_exception( error );
+
+	// Every chunk parser dropped points which are not later than its own previous point,
+	// so a chunk is strictly chronological and single parser would keep only its points later than
+	// the last point of previous chunks.
+	ProfileScope const scope( "Merge chunks" );
+	std::vector< Position > & oPositions = oRaw.positions;
+	size_t total = 0;
+	for( RawPositions const & chunk: chunks )
+		total += chunk.positions.size();
+	oPositions.reserve( oPositions.size() + total );
+	if( iFields )
+		oRaw.fields.reserve( oRaw.fields.size() + total );
+	for( RawPositions const & chunk: chunks ) {
+		auto first = chunk.positions.begin();
+		if( !oPositions.empty() )
+			first = std::upper_bound( chunk.positions.begin(), chunk.positions.end(), oPositions.back().time,
+					[]( time_t iTime, Position const & iPos ) { return iTime < iPos.time; } );
+		size_t const skipped = size_t( first - chunk.positions.begin() );
+		Profiler::Add( Profiler::SkippedNonChronological, uint64_t( skipped ) );
+		// the gaps of the chunk without the pairs of a skipped position, plus the one at the border of chunks
+		size_t gapCount = chunk.gapCount;
+		for( size_t i = 1; i <= skipped && i < chunk.positions.size(); ++i )
+			gapCount -= chunk.positions[ i ].time - chunk.positions[ i - 1 ].time > iGapTime;
+		if( !oPositions.empty() && first != chunk.positions.end() )
+			gapCount += first->time - oPositions.back().time > iGapTime;
+		oRaw.gapCount += gapCount;
+		oPositions.insert( oPositions.end(), first, chunk.positions.end() );
+		if( iFields )
+			oRaw.fields.insert( oRaw.fields.end(), chunk.fields.begin() + skipped, chunk.fields.end() );
+	}
+}
+
+//-------------------------------------------------------------------------
+/// Makes a track of parsed positions and runs @a iStages on it.
+/// The requested fields become extra columns before the stages, so the stages keep them in line with the positions.
+Track MakeStagedTrack( RawPositions const & iRaw, gpx::ReadOptions const & iOptions, gpx::TTrackStages const & iStages )
+{
+	std::vector< Position > const & iRawPositions = iRaw.positions;
+	Track result;
+	result.reserve( iRawPositions.size() + iRaw.gapCount );
+	for( Position const & pos: iRawPositions )
+		result.push_back( pos );
+
+	if( !iRaw.fields.empty() ) {
+		for( int field = 0; field < gpx::FIELD_COUNT; ++field ) {
+			if( !( iOptions.fields & ( 1u << field ) ) )
+				continue;
+			std::vector< double > & column = result.extraColumns[ gpx::FIELD_NAMES[ field ] ];
+			column.reserve( iRawPositions.size() + iRaw.gapCount );
+			for( TFieldValues const & values: iRaw.fields )
+				column.push_back( values[ field ] );
+		}
+		if( iOptions.deviceSpeed )
+			for( size_t i = 0; i < iRaw.fields.size(); ++i ) {
+				double const speed = iRaw.fields[ i ][ gpx::FIELD_SPEED ];
+				if( speed >= 0 ) // NaN is not
+					result.speed[ i ] = speed * 3.6; // m/s to km/h
+			}
+	}
+
+	gpx::RunStages( iStages, result );
+	return result;
+}
+
+//-------------------------------------------------------------------------
+/// Segments MakeDefaultTrack calculates at once: their columns are still in cache for the speeds,
+/// and a multiple of 4 keeps the SIMD groups of SegmentDistances the ones of the whole track.
+size_t const SEGMENT_BLOCK = 4096;
+
+//-------------------------------------------------------------------------
+/// DefaultStages< TGeodesic > fused into one pass over the parsed positions: the order is checked, pauses are closed
+/// and the distances and speeds are calculated behind the appended positions by blocks of SEGMENT_BLOCK.
+/// The result is the same as the one of the stages. false when the positions are out of order
+/// (the parsers never give such), @a oTrack is to be made by the stages then.
+template< typename TGeodesic >
+bool MakeDefaultTrack( RawPositions const & iRaw, gpx::ReadOptions const & iOptions, Track & oTrack )
+{
+	ProfileScope const scope( "Make track" );
+	bool const cached = std::is_same< TGeodesic, gpx::Equirectangular >::value; // the distance cache has this formula only
+	std::vector< Position > const & iRawPositions = iRaw.positions;
+	// the only allocation of the columns: the gap positions are counted by the parsing
+	size_t const size = iRawPositions.size() + iRaw.gapCount;
+	oTrack.reserve( size );
+	if( cached )
+		oTrack.distance.reserve( size );
+	std::vector< std::pair< int, std::vector< double > * > > fieldColumns;
+	if( !iRaw.fields.empty() )
+		for( int field = 0; field < gpx::FIELD_COUNT; ++field )
+			if( iOptions.fields & ( 1u << field ) ) {
+				std::vector< double > & column = oTrack.extraColumns[ gpx::FIELD_NAMES[ field ] ];
+				column.reserve( size );
+				fieldColumns.emplace_back( field, &column );
+			}
+
+	size_t calculated = 0; // segments with the distance and speed
+	auto const append = [&]( size_t iRawIndex, time_t iTime, double iSpeed ) {
+		Position const & pos = iRawPositions[ iRawIndex ];
+		oTrack.x.push_back( pos.x );
+		oTrack.y.push_back( pos.y );
+		oTrack.time.push_back( iTime );
+		oTrack.speed.push_back( iSpeed );
+		if( cached )
+			oTrack.distance.push_back( 0 );
+		for( auto const & column: fieldColumns )
+			column.second->push_back( iRaw.fields[ iRawIndex ][ column.first ] );
+		if( oTrack.size() > calculated + SEGMENT_BLOCK ) {
+			gpx::FillSegmentSpeeds< TGeodesic >( oTrack, calculated, calculated + SEGMENT_BLOCK );
+			calculated += SEGMENT_BLOCK;
+		}
+	};
+
+	size_t gapCount = 0;
+	for( size_t i = 0; i < iRawPositions.size(); ++i ) {
+		time_t const time = iRawPositions[ i ].time;
+		double speed = iRawPositions[ i ].speed;
+		if( iOptions.deviceSpeed && !iRaw.fields.empty() ) {
+			double const deviceSpeed = iRaw.fields[ i ][ gpx::FIELD_SPEED ];
+			if( deviceSpeed >= 0 ) // NaN is not
+				speed = deviceSpeed * 3.6; // m/s to km/h
+		}
+		if( i > 0 ) {
+			time_t const previous = oTrack.time.back();
+			if( time < previous ) {
+				oTrack = Track();
+				return false;
+			}
+			if( time - previous > iOptions.gapTime ) {
+				oTrack.speed.back() = 0;
+				append( i, time - 1, 0 );
+				++gapCount;
+			}
+		}
+		append( i, time, speed );
+	}
+	Profiler::Add( Profiler::GapsFilled, gapCount );
+
+	gpx::FillSegmentSpeeds< TGeodesic >( oTrack, calculated, oTrack.size() - 1 );
+	if( oTrack.speed.back() < 0 )
+		oTrack.speed.back() = oTrack.speed[ oTrack.size() - 2 ];
+	return true;
+}
+
+//-------------------------------------------------------------------------
+/// Makes a track of parsed positions processed by the stages of @a iOptions, a track of less than 2 positions is empty.
+Track MakeTrack( RawPositions const & iRaw, gpx::ReadOptions const & iOptions )
+{
+	Profiler::Add( Profiler::PositionsRead, iRaw.positions.size() );
+	if( iRaw.positions.size() < 2 )
+		return {};
+	if( !iOptions.stages.empty() )
+		return MakeStagedTrack( iRaw, iOptions, iOptions.stages );
+
+	return gpx::WithGeodesic( iOptions.geodesic, [&]( auto iGeodesic ) {
+		typedef decltype( iGeodesic ) TGeodesic;
+		Track result;
+		if( MakeDefaultTrack< TGeodesic >( iRaw, iOptions, result ) )
+			return result;
+		return MakeStagedTrack( iRaw, iOptions, gpx::DefaultStages< TGeodesic >( iOptions.gapTime ) );
+	} );
+}
+
+//-------------------------------------------------------------------------
+/// Makes track from positions returned by @a iReadRawPositions, throws only gpx::ReadCancelled.
+/// When the reading fails the error is reported to stderr and the track is made of the positions read before it,
+/// like the one of a truncated file; @a oComplete is false then.
+template< typename TReadRawPositions >
+Track SafeReadTrack( gpx::ReadOptions const & iOptions, TReadRawPositions const & iReadRawPositions, bool & oComplete )
+{
+	oComplete = false;
+	try
+	{
+		RawPositions rawPositions;
+		try
+		{
+			iReadRawPositions( rawPositions );
+			oComplete = true;
+		}
+		catch( gpx::ReadCancelled const & )
+		{
+			throw;
+		}
+		catch( std::exception & e )
+		{
+			std::cerr << "gpx: std::exception: " << e.what() << ", " << rawPositions.positions.size() << " positions are read from stream" << std::endl;
+		}
+		return MakeTrack( rawPositions, iOptions );
+	}
+	catch( gpx::ReadCancelled const & )
+	{
+		throw;
+	}
+	catch( std::exception & e )
+	{
+		std::cerr << "gpx: std::exception: " << e.what() << ", unable to read track from stream" << std::endl;
+	}
+	catch( ... )
+	{
+		std::cerr << "gpx: Unknown exception, unable to read track from stream" << std::endl;
+	}
+	oComplete = false;
+	return {};
+}
+
+//-------------------------------------------------------------------------
+Track ReadStream( std::istream & ioStream, gpx::ReadOptions const & iOptions, size_t iTotal, bool & oComplete )
+{
+	return SafeReadTrack( iOptions, [&]( RawPositions & oRaw ) {
+		ReadProgress progress( iOptions, iTotal );
+		unsigned const fields = ParsedFields( iOptions );
+		MParserGPX parserGpx( ioStream, fields );
+		ReadRawPositions( parserGpx, progress, fields != 0, iOptions.gapTime, oRaw );
+		progress.Finish();
+	}, oComplete );
+}
+
+//-------------------------------------------------------------------------
+/// Parses a gzip or zstd compressed file while it is decompressed by another thread.
+Track ReadCompressedFile( std::string const & iFilePath, CompressedInput::ECompression iCompression, gpx::ReadOptions const & iOptions,
+		bool & oComplete )
+{
+	CompressedInput input( iFilePath, iCompression );
+	gpx::ReadOptions options = iOptions;
+	if( iOptions.progress ) // the size of decompressed data is unknown, the compressed bytes are reported
+		options.progress = [&]( size_t, size_t ) { iOptions.progress( size_t( input.CompressedRead() ), size_t( input.CompressedSize() ) ); };
+	return ReadStream( input.Stream(), options, size_t( input.CompressedSize() ), oComplete );
+}
+
+//-------------------------------------------------------------------------
+/// Reads a plain or compressed file, @a oComplete is false when the track is made of a part of the file because of an error.
+Track ReadTrackFile( std::string const & iFilePath, gpx::ReadOptions const & iOptions, bool & oComplete )
+{
+	CompressedInput::ECompression const compression = CompressedInput::Detect( iFilePath );
+	if( compression != CompressedInput::ECompression::None )
+		return ReadCompressedFile( iFilePath, compression, iOptions, oComplete );
+
+	// Parse straight out of the page cache when possible, it saves a copy of the whole file on the heap.
+	MappedFile const mapping( iFilePath );
+	if( mapping.IsMapped() ) {
+		std::string_view const data = mapping.Data();
+		unsigned threadCount = iOptions.threadCount ? iOptions.threadCount : std::max( std::thread::hardware_concurrency(), 1u );
+		threadCount = unsigned( std::min< size_t >( threadCount, data.size() / MIN_BYTES_PER_THREAD ) );
+		return SafeReadTrack( iOptions, [&]( RawPositions & oRaw ) {
+			ReadProgress progress( iOptions, data.size() );
+			unsigned const fields = ParsedFields( iOptions );
+			if( threadCount > 1 ) {
+				ReadRawPositionsParallel( data, threadCount, fields, iOptions.gapTime, iOptions.threadPool ? *iOptions.threadPool : SharedReadPool(), progress, oRaw );
+			} else {
+				MParserGPX parserGpx( data, fields );
+				ReadRawPositions( parserGpx, progress, fields != 0, iOptions.gapTime, oRaw );
+			}
+			progress.Finish();
+		}, oComplete );
+	}
+
+	std::ifstream file( iFilePath.c_str(), std::ios::binary | std::ios::in | std::ios::ate );
+
+	if( !file )
+		throw std::logic_error( "gpx: Can't open GPX track file: " + iFilePath );
+
+	std::streamoff const size = file.tellg();
+	file.seekg( 0 );
+	return ReadStream( file, iOptions, size > 0 ? size_t( size ) : 0, oComplete );
+}
+
+//-------------------------------------------------------------------------
+Track Simplified( Track && ioTrack, gpx::ReadOptions const & iOptions )
+{
+	if( !iOptions.simplify.IsEnabled() ) {
+		if( iOptions.simplifyReport )
+			*iOptions.simplifyReport = gpx::SimplifyReport{ ioTrack.size(), ioTrack.size() };
+		return std::move( ioTrack );
+	}
+	return gpx::WithGeodesic( iOptions.geodesic, [&]( auto iGeodesic ) {
+		return gpx::SimplifyTrack< decltype( iGeodesic ) >( ioTrack, iOptions.simplify, iOptions.simplifyReport );
+	} );
+}
+
+//#########################################################################
+//---------------------------- Namespace gpx ------------------------------
+//#########################################################################
+Track gpx::ReadTrack( std::string const & iFilePath, ReadOptions const & iOptions )
+{
+	ProfileScope const scope( "ReadTrack" );
+	// the result of custom stages can't be told apart by a key, such tracks are not cached
+	bool complete = true;
+	if( !iOptions.useCache || !iOptions.stages.empty() )
+		return Simplified( ReadTrackFile( iFilePath, iOptions, complete ), iOptions );
+
+	// fields, the device speed and the geodesic change the result, without them the key is the one of older caches
+	uint64_t const processingKey = uint64_t( iOptions.gapTime ) ^ ( uint64_t( iOptions.fields ) << 48 ) ^ ( uint64_t( iOptions.deviceSpeed ) << 56 ) ^
+			( uint64_t( iOptions.geodesic ) << 57 );
+	Track result;
+	if( gpx::ReadTrackCache( iFilePath, processingKey, result ) )
+		return Simplified( std::move( result ), iOptions );
+	result = ReadTrackFile( iFilePath, iOptions, complete );
+	if( !result.empty() && complete ) // a part of a broken file is not cached, the error is reported on every reading
+		gpx::WriteTrackCache( iFilePath, processingKey, result );
+	return Simplified( std::move( result ), iOptions );
+}
+
+//-------------------------------------------------------------------------
+Track gpx::ReadTrack( std::istream & ioStream, ReadOptions const & iOptions )
+{
+	ProfileScope const scope( "ReadTrack" );
+	bool complete = true;
+	return Simplified( ReadStream( ioStream, iOptions, 0, complete ), iOptions );
+}
+
+//-------------------------------------------------------------------------
+void gpx::ReadPositions( std::string_view iData, time_t iAfter, ReadOptions const & iOptions, Track & ioTrack )
+{
+	ProfileScope const scope( "Parse" );
+	unsigned const parsedFields = ParsedFields( iOptions );
+	std::vector< std::pair< int, std::vector< double > * > > fieldColumns;
+	for( int field = 0; field < FIELD_COUNT; ++field )
+		if( iOptions.fields & ( 1u << field ) )
+			fieldColumns.emplace_back( field, &ioTrack.extraColumns[ FIELD_NAMES[ field ] ] );
+
+	MParserGPX parserGpx( iData, parsedFields );
+	Position pi;
+	TFieldValues fields;
+	while( parserGpx.GetNextTrackPos( pi, parsedFields ? &fields : nullptr ) ) {
+		if( pi.time <= iAfter ) {
+			Profiler::Add( Profiler::SkippedNonChronological, 1 );
+			continue;
+		}
+		if( iOptions.deviceSpeed && fields[ FIELD_SPEED ] >= 0 ) // NaN is not
+			pi.speed = fields[ FIELD_SPEED ] * 3.6; // m/s to km/h
+		ioTrack.push_back( pi );
+		for( auto const & column: fieldColumns )
+			column.second->push_back( fields[ column.first ] );
+	}
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <stdexcept>
+#include <functional>
+#include "Geodesy.h"
+#include "SegmentKernels.h"
+#include "TrackSimplify.h"
+#include "TrackStages.h"
+
+struct Position
+{
+	explicit Position( double iX = std::numeric_limits< double >::quiet_NaN(), double iY = std::numeric_limits< double >::quiet_NaN(), time_t iTime = 0, float iSpeed = -1 )
+		: x( iX )
+		, y( iY )
+		, time( iTime )
+		, speed( iSpeed )
+	{}
+
+	/// @a TGeodesic - a geodesic policy of Geodesy.h.
+	template< typename TGeodesic = gpx::Equirectangular >
+	double DistanceInKM( Position const & iPnt ) const {
+		return TGeodesic::Meters( x, y, iPnt.x, iPnt.y ) / 1000.0;
+	}
+
+	template< typename TGeodesic = gpx::Equirectangular >
+	void CalculateSpeedByNext( Position const & iNext ) {
+		speed = gpx::SegmentSpeed( TGeodesic::Meters( x, y, iNext.x, iNext.y ), time, iNext.time );
+	}
+	std::string trace() const {
+		return "x=" + std::to_string( x ) + ", y=" + std::to_string( y ) + ", time=" + std::to_string( time ) + ", speed=" + std::to_string( speed );
+	}
+
+	double x = 0;
+	double y = 0;
+	time_t time = 0;
+	double speed = -1;
+};
+
+struct Track; // Track.h
+class ThreadPool; // ThreadPool.h
+
+namespace gpx
+{
+	/// Optional children of <trkpt> read to Track::extraColumns, a column is named as its tag (FIELD_NAMES)
+	/// and keeps values in the units of the file, NaN for positions without the tag.
+	enum EField { FIELD_ELEVATION, FIELD_SPEED, FIELD_COURSE, FIELD_HDOP, FIELD_SATELLITES, FIELD_COUNT };
+	char const * const FIELD_NAMES[ FIELD_COUNT ] = { "ele", "speed", "course", "hdop", "sat" };
+	unsigned const ALL_FIELDS = ( 1u << FIELD_COUNT ) - 1;
+
+	/// Tuning of a track reading.
+	struct ReadOptions
+	{
+		/// Threads parsing one file, 0 - as many as cores. Small files are always parsed by one thread.
+		unsigned threadCount = 0;
+		/// Pool running the parsing threads besides the calling one, nullptr - a pool shared by all readings.
+		/// No threads are started by a reading, a pool busy with other tasks just gives it fewer helpers.
+		ThreadPool * threadPool = nullptr;
+		/// Called with parsed bytes and the data size (0 when unknown) while parsing, may be called from parsing threads.
+		std::function< void( size_t iBytesRead, size_t iBytesTotal ) > progress;
+		/// Polled while parsing, reading stops with ReadCancelled when it returns true. May be called from parsing threads.
+		std::function< bool() > isCancelled;
+		/// Pauses longer than that many seconds are closed with zero speed, see GapStage.
+		time_t gapTime = DEFAULT_GAP_TIME;
+		/// Bits ( 1 << EField ) of the fields to read, unknown tags are skipped anyway.
+		unsigned fields = 0;
+		/// Positions with <speed> (m/s) get it as their speed instead of the one calculated by SpeedStage.
+		bool deviceSpeed = false;
+		/// Formula of the calculated speeds (and of the simplification), see Geodesy.h.
+		/// TrackInfo::calculate of the same policy gives distances consistent with the speeds.
+		EGeodesic geodesic = EGeodesic::Equirectangular;
+		/// Processing of parsed positions, empty - DefaultStages< geodesic >( gapTime ), run as one pass while the track is made.
+		TTrackStages stages;
+		/// Load the track from the binary cache next to the file (see TrackCache.h) when it is up to date,
+		/// otherwise parse the file and write the cache. Tracks of custom stages are not cached.
+		bool useCache = false;
+		/// Simplification of the read track, see SimplifyTrack. The cache keeps the track as it is parsed.
+		SimplifyOptions simplify;
+		/// Receives the result of the simplification when not null.
+		SimplifyReport * simplifyReport = nullptr;
+	};
+
+	/// Thrown by ReadTrack when ReadOptions::isCancelled returns true.
+	struct ReadCancelled: std::runtime_error
+	{
+		ReadCancelled(): std::runtime_error( "gpx: Reading is cancelled" ) {}
+	};
+
+	/// Restore positions from file to a track. Gzip and zstd compressed files are recognized by their magic bytes
+	/// and parsed while they are decompressed (see CompressedInput), progress is reported in compressed bytes then.
+	/// A truncated or corrupt file gives the track of the positions before the error, which is reported to stderr.
+	Track ReadTrack( std::string const & iFilePath, ReadOptions const & iOptions = ReadOptions() );
+	Track ReadTrack( std::istream & ioStream, ReadOptions const & iOptions = ReadOptions() );
+
+	/// Appends positions of the <trkpt> elements of @a iData later than @a iAfter to @a ioTrack, as they are parsed,
+	/// without stages: only ReadOptions::fields and deviceSpeed are applied, like ReadTrack does before the stages.
+	/// @a ioTrack is empty or was read with the same options. The data may be any part of a file starting between elements, see TrackTail.
+	void ReadPositions( std::string_view iData, time_t iAfter, ReadOptions const & iOptions, Track & ioTrack );
+}
+
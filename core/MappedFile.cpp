@@ -0,0 +1,83 @@
+#include <stdint.h>
+#include "MappedFile.h"
+
+#if defined( _WIN32 )
+#include <windows.h>
+#elif defined( __unix__ ) || defined( __APPLE__ )
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#if defined( _WIN32 )
+//-------------------------------------------------------------------------
+MappedFile::MappedFile( std::string const & iFilePath )
+{
+	HANDLE const file = ::CreateFileA( iFilePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr );
+	if( file == INVALID_HANDLE_VALUE )
+		return;
+
+	LARGE_INTEGER size = {};
+	if( ::GetFileSizeEx( file, &size ) && size.QuadPart > 0 && size.QuadPart <= LONGLONG( SIZE_MAX ) ) {
+		HANDLE const mapping = ::CreateFileMappingA( file, nullptr, PAGE_READONLY, 0, 0, nullptr );
+		if( mapping != nullptr ) {
+			// the view keeps the mapping object alive, both handles can be closed
+			void const * const view = ::MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+			if( view != nullptr ) {
+				m_data = static_cast< char const * >( view );
+				m_size = size_t( size.QuadPart );
+			}
+			::CloseHandle( mapping );
+		}
+	}
+	::CloseHandle( file );
+}
+
+//-------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+	if( m_data != nullptr )
+		::UnmapViewOfFile( m_data );
+}
+
+#elif defined( __unix__ ) || defined( __APPLE__ )
+//-------------------------------------------------------------------------
+MappedFile::MappedFile( std::string const & iFilePath )
+{
+	int const fd = ::open( iFilePath.c_str(), O_RDONLY );
+	if( fd == -1 )
+		return;
+
+	struct stat info = {};
+	if( ::fstat( fd, &info ) == 0 && S_ISREG( info.st_mode ) && info.st_size > 0 ) {
+		// the mapping stays valid after the descriptor is closed
+		void * const data = ::mmap( nullptr, size_t( info.st_size ), PROT_READ, MAP_PRIVATE, fd, 0 );
+		if( data != MAP_FAILED ) {
+			::posix_madvise( data, size_t( info.st_size ), POSIX_MADV_SEQUENTIAL );
+			m_data = static_cast< char const * >( data );
+			m_size = size_t( info.st_size );
+		}
+	}
+	::close( fd );
+}
+
+//-------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+	if( m_data != nullptr )
+		::munmap( const_cast< char * >( m_data ), m_size );
+}
+
+#else
+//-------------------------------------------------------------------------
+MappedFile::MappedFile( std::string const & )
+{
+}
+
+//-------------------------------------------------------------------------
+MappedFile::~MappedFile()
+{
+}
+#endif
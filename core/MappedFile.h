@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/**
+ * @class MappedFile is a read-only memory mapping of a whole file.
+ *
+ * IsMapped() is false when the file can't be mapped (missing file, empty file, special file,
+ * platform without mapping support), the caller should read the file in a usual way then.
+ */
+class MappedFile
+{
+public:
+	explicit MappedFile( std::string const & iFilePath );
+	~MappedFile();
+
+	MappedFile( MappedFile const & ) = delete;
+	MappedFile & operator=( MappedFile const & ) = delete;
+
+	bool IsMapped() const { return m_data != nullptr; }
+	std::string_view Data() const { return std::string_view( m_data, m_size ); }
+
+private:
+	char const * m_data = nullptr;
+	size_t       m_size = 0;
+};
@@ -0,0 +1,170 @@
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+#include <string.h>
+#include "Profiler.h"
+
+namespace
+{
+	struct Span
+	{
+		char const * name;
+		unsigned     thread;
+		int64_t      start;
+		int64_t      end;
+	};
+
+	char const * const COUNTER_NAMES[ Profiler::COUNTER_COUNT ] = {
+		"positions", "skipped no coordinates", "skipped no time", "skipped bad time",
+		"skipped non-chronological", "gaps filled", "simplified", "stream read", "tag scan", "time decode"
+	};
+
+	std::mutex g_spansMutex;
+	std::vector< Span > g_spans;      /// guarded by g_spansMutex
+	std::atomic< uint64_t > g_counters[ Profiler::COUNTER_COUNT ];
+	std::atomic< unsigned > g_threadCount( 0 );
+
+	//-------------------------------------------------------------------------
+	/// The counter sums nanoseconds.
+	bool IsDuration( int iCounter )
+	{
+		return iCounter == Profiler::StreamReadNs || iCounter == Profiler::TagScanNs || iCounter == Profiler::TimeDecodeNs;
+	}
+
+	//-------------------------------------------------------------------------
+	/// Small number of the calling thread, Chrome trace wants integer thread ids.
+	unsigned ThreadNumber()
+	{
+		thread_local unsigned const number = ++g_threadCount;
+		return number;
+	}
+
+	//-------------------------------------------------------------------------
+	/// Names are literals of this project, only quotes and backslashes could break JSON.
+	std::string JsonName( char const * iName )
+	{
+		std::string result;
+		for( char const * c = iName; *c; ++c ) {
+			if( *c == '"' || *c == '\\' )
+				result += '\\';
+			result += *c;
+		}
+		return result;
+	}
+}
+
+std::atomic< bool > Profiler::s_enabled( false );
+
+//-------------------------------------------------------------------------
+void Profiler::SetEnabled( bool iEnabled )
+{
+	s_enabled.store( iEnabled, std::memory_order_relaxed );
+}
+
+//-------------------------------------------------------------------------
+void Profiler::Reset()
+{
+	std::lock_guard< std::mutex > lock( g_spansMutex );
+	g_spans.clear();
+	for( std::atomic< uint64_t > & counter: g_counters )
+		counter.store( 0, std::memory_order_relaxed );
+}
+
+//-------------------------------------------------------------------------
+void Profiler::Add( ECounter iCounter, uint64_t iValue )
+{
+	if( IsEnabled() && iValue != 0 )
+		g_counters[ iCounter ].fetch_add( iValue, std::memory_order_relaxed );
+}
+
+//-------------------------------------------------------------------------
+uint64_t Profiler::Get( ECounter iCounter )
+{
+	return g_counters[ iCounter ].load( std::memory_order_relaxed );
+}
+
+//-------------------------------------------------------------------------
+int64_t Profiler::Now()
+{
+	return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+//-------------------------------------------------------------------------
+void Profiler::AddSpan( char const * iName, int64_t iStart, int64_t iEnd )
+{
+	Span const span = { iName, ThreadNumber(), iStart, iEnd };
+	std::lock_guard< std::mutex > lock( g_spansMutex );
+	g_spans.push_back( span );
+}
+
+//-------------------------------------------------------------------------
+void Profiler::WriteChromeTrace( std::ostream & ioStream )
+{
+	std::vector< Span > spans;
+	{
+		std::lock_guard< std::mutex > lock( g_spansMutex );
+		spans = g_spans;
+	}
+	int64_t origin = spans.empty() ? Now() : spans.front().start;
+	int64_t last = origin;
+	for( Span const & span: spans ) {
+		origin = std::min( origin, span.start );
+		last = std::max( last, span.end );
+	}
+
+	char buffer[ 256 ];
+	ioStream << "{\"traceEvents\": [\n";
+	char const * separator = "";
+	for( Span const & span: spans ) {
+		// microseconds, as the format wants
+		snprintf( buffer, sizeof( buffer ), "\"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+			span.thread, ( span.start - origin ) / 1e3, ( span.end - span.start ) / 1e3 );
+		ioStream << separator << "  {\"name\": \"" << JsonName( span.name ) << "\", " << buffer;
+		separator = ",\n";
+	}
+	for( int i = 0; i < COUNTER_COUNT; ++i ) {
+		snprintf( buffer, sizeof( buffer ), "  {\"name\": \"%s%s\", \"ph\": \"C\", \"pid\": 1, \"tid\": 0, \"ts\": %.3f, \"args\": {\"value\": %llu}}",
+			COUNTER_NAMES[ i ], IsDuration( i ) ? " ns" : "", ( last - origin ) / 1e3, (unsigned long long)Get( ECounter( i ) ) );
+		ioStream << separator << buffer;
+		separator = ",\n";
+	}
+	ioStream << "\n]}\n";
+}
+
+//-------------------------------------------------------------------------
+std::string Profiler::Summary()
+{
+	// total time by name in the order of the first span end
+	std::vector< std::pair< char const *, int64_t > > totals;
+	{
+		std::lock_guard< std::mutex > lock( g_spansMutex );
+		for( Span const & span: g_spans ) {
+			auto it = totals.begin();
+			while( it != totals.end() && strcmp( it->first, span.name ) != 0 )
+				++it;
+			if( it == totals.end() )
+				it = totals.insert( it, std::make_pair( span.name, int64_t( 0 ) ) );
+			it->second += span.end - span.start;
+		}
+	}
+
+	std::string result;
+	char buffer[ 128 ];
+	for( auto const & total: totals ) {
+		snprintf( buffer, sizeof( buffer ), "%s%s %.3f s", result.empty() ? "" : ", ", total.first, total.second / 1e9 );
+		result += buffer;
+	}
+	for( int i = 0; i < COUNTER_COUNT; ++i ) {
+		uint64_t const value = Get( ECounter( i ) );
+		if( value == 0 )
+			continue;
+		if( IsDuration( i ) )
+			snprintf( buffer, sizeof( buffer ), "%s%s %.3f s", result.empty() ? "" : "; ", COUNTER_NAMES[ i ], value / 1e9 );
+		else
+			snprintf( buffer, sizeof( buffer ), "%s%s %llu", result.empty() ? "" : "; ", COUNTER_NAMES[ i ], (unsigned long long)value );
+		result += buffer;
+	}
+	return result;
+}
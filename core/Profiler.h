@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <ostream>
+#include <stdint.h>
+
+/**
+ * @class Profiler collects timings and counters of track processing.
+ *
+ * Disabled by default: then ProfileScope costs one relaxed atomic load and counters are not summed.
+ * When enabled, every ProfileScope adds a span and counters are summed over all threads until Reset().
+ * The collected run is written as Chrome trace JSON (chrome://tracing, ui.perfetto.dev) or as a summary line.
+ */
+class Profiler
+{
+public:
+	enum ECounter
+	{
+		PositionsRead,            /// positions accepted by the parser
+		SkippedNoCoordinates,     /// <trkpt> without valid lat and lon
+		SkippedNoTime,            /// <trkpt> without <time>
+		SkippedBadTime,           /// <time> of unknown format or out of range
+		SkippedNonChronological,  /// not later than the previous position
+		GapsFilled,               /// pauses longer than ReadOptions::gapTime closed with zero speed
+		PositionsSimplified,      /// positions removed by gpx::SimplifyTrack
+		StreamReadNs,             /// time spent in reading of a stream, a mapped file is read while parsed
+		TagScanNs,                /// time spent in scanning of <trkpt> tags
+		TimeDecodeNs,             /// time spent in decoding of <time> values
+		COUNTER_COUNT
+	};
+
+	static void SetEnabled( bool iEnabled );
+	static bool IsEnabled() { return s_enabled.load( std::memory_order_relaxed ); }
+
+	/// Drops collected spans and counters.
+	static void Reset();
+
+	static void Add( ECounter iCounter, uint64_t iValue );
+	static uint64_t Get( ECounter iCounter );
+
+	/// Spans as complete events and counters as counter events of the Chrome trace format.
+	static void WriteChromeTrace( std::ostream & ioStream );
+	/// Total time of every span name and the non zero counters, in one line.
+	static std::string Summary();
+
+	/// Nanoseconds of a monotonic clock.
+	static int64_t Now();
+
+private:
+	friend class ProfileScope;
+	static void AddSpan( char const * iName, int64_t iStart, int64_t iEnd );
+
+	static std::atomic< bool > s_enabled;
+};
+
+/// Adds a span named @a iName from construction till destruction when Profiler is enabled.
+/// @a iName must be a string literal, only the pointer is kept.
+class ProfileScope
+{
+public:
+	explicit ProfileScope( char const * iName )
+		: m_name( iName )
+		, m_start( Profiler::IsEnabled() ? Profiler::Now() : -1 )
+	{}
+	~ProfileScope()
+	{
+		if( m_start >= 0 )
+			Profiler::AddSpan( m_name, m_start, Profiler::Now() );
+	}
+
+	ProfileScope( ProfileScope const & ) = delete;
+	ProfileScope & operator=( ProfileScope const & ) = delete;
+
+private:
+	char const * m_name;
+	int64_t      m_start; /// -1 when the profiler was disabled
+};
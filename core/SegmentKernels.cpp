@@ -0,0 +1,153 @@
+#include <math.h>
+#include <type_traits>
+#include "Geodesy.h"
+#include "Track.h"
+#include "SegmentKernels.h"
+
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+#define GPX_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	inline double SegmentMeters( double iX, double iY, double iNextX, double iNextY ) {
+		return gpx::Equirectangular::Meters( iX, iY, iNextX, iNextY );
+	}
+
+#ifdef GPX_AVX2_KERNEL
+	/// cos( x ) for |x| <= PI / 2 with relative error < 1e-15.
+	/// Taylor series of cos( x ) for |x| <= PI / 4 and of sin( PI / 2 - |x| ) above it, both up to the 16th power.
+	__attribute__(( target( "avx2,fma" ) ))
+	inline __m256d CosAvx2( __m256d iX ) {
+		__m256d const absX = _mm256_and_pd( iX, _mm256_castsi256_pd( _mm256_set1_epi64x( 0x7fffffffffffffffLL ) ) );
+		__m256d const nearZero = _mm256_cmp_pd( absX, _mm256_set1_pd( PI / 4 ), _CMP_LE_OQ );
+		// PI / 2 = hi + lo, hi - absX is exact for absX >= PI / 4, so the argument keeps precision near the poles
+		__m256d const complement = _mm256_add_pd( _mm256_sub_pd( _mm256_set1_pd( 1.5707963267948966 ), absX ), _mm256_set1_pd( 6.123233995736766e-17 ) );
+		__m256d const arg = _mm256_blendv_pd( complement, absX, nearZero );
+		__m256d const t = _mm256_mul_pd( arg, arg );
+
+		__m256d cosine = _mm256_set1_pd( 1.0 / 20922789888000.0 );                        //  1 / 16!
+		cosine = _mm256_fmadd_pd( cosine, t, _mm256_set1_pd( -1.0 / 87178291200.0 ) );    // -1 / 14!
+		cosine = _mm256_fmadd_pd( cosine, t, _mm256_set1_pd( 1.0 / 479001600.0 ) );       //  1 / 12!
+		cosine = _mm256_fmadd_pd( cosine, t, _mm256_set1_pd( -1.0 / 3628800.0 ) );        // -1 / 10!
+		cosine = _mm256_fmadd_pd( cosine, t, _mm256_set1_pd( 1.0 / 40320.0 ) );           //  1 / 8!
+		cosine = _mm256_fmadd_pd( cosine, t, _mm256_set1_pd( -1.0 / 720.0 ) );            // -1 / 6!
+		cosine = _mm256_fmadd_pd( cosine, t, _mm256_set1_pd( 1.0 / 24.0 ) );              //  1 / 4!
+		cosine = _mm256_fmadd_pd( cosine, t, _mm256_set1_pd( -0.5 ) );                    // -1 / 2!
+		cosine = _mm256_fmadd_pd( cosine, t, _mm256_set1_pd( 1.0 ) );
+
+		__m256d sine = _mm256_set1_pd( -1.0 / 1307674368000.0 );                          // -1 / 15!
+		sine = _mm256_fmadd_pd( sine, t, _mm256_set1_pd( 1.0 / 6227020800.0 ) );          //  1 / 13!
+		sine = _mm256_fmadd_pd( sine, t, _mm256_set1_pd( -1.0 / 39916800.0 ) );           // -1 / 11!
+		sine = _mm256_fmadd_pd( sine, t, _mm256_set1_pd( 1.0 / 362880.0 ) );              //  1 / 9!
+		sine = _mm256_fmadd_pd( sine, t, _mm256_set1_pd( -1.0 / 5040.0 ) );               // -1 / 7!
+		sine = _mm256_fmadd_pd( sine, t, _mm256_set1_pd( 1.0 / 120.0 ) );                 //  1 / 5!
+		sine = _mm256_fmadd_pd( sine, t, _mm256_set1_pd( -1.0 / 6.0 ) );                  // -1 / 3!
+		sine = _mm256_mul_pd( _mm256_fmadd_pd( sine, t, _mm256_set1_pd( 1.0 ) ), arg );
+
+		return _mm256_blendv_pd( sine, cosine, nearZero );
+	}
+
+	__attribute__(( target( "avx2,fma" ) ))
+	void SegmentDistancesAvx2( double const * iX, double const * iY, size_t iCount, double * oMeters ) {
+		__m256d const half = _mm256_set1_pd( 0.5 );
+		__m256d const piFactor = _mm256_set1_pd( PI_FACTOR );
+		__m256d const oneMeter = _mm256_set1_pd( ONE_METER );
+		__m256d const maxLatitude = _mm256_set1_pd( 90.0 );
+		__m256d const absMask = _mm256_castsi256_pd( _mm256_set1_epi64x( 0x7fffffffffffffffLL ) );
+		size_t const segmentCount = iCount - 1;
+		size_t i = 0;
+		for( ; i + 4 <= segmentCount; i += 4 ) {
+			__m256d const x = _mm256_loadu_pd( iX + i );
+			__m256d const nextX = _mm256_loadu_pd( iX + i + 1 );
+			__m256d const y = _mm256_loadu_pd( iY + i );
+			__m256d const nextY = _mm256_loadu_pd( iY + i + 1 );
+
+			__m256d const meanY = _mm256_mul_pd( _mm256_add_pd( y, nextY ), half );
+			__m256d const dx = _mm256_mul_pd( _mm256_sub_pd( x, nextX ), CosAvx2( _mm256_mul_pd( meanY, piFactor ) ) );
+			__m256d const dy = _mm256_sub_pd( y, nextY );
+			__m256d const len = _mm256_sqrt_pd( _mm256_add_pd( _mm256_mul_pd( dx, dx ), _mm256_mul_pd( dy, dy ) ) );
+			_mm256_storeu_pd( oMeters + i, _mm256_div_pd( len, oneMeter ) );
+
+			// the polynomial is valid for real latitudes only, NaN or |y| > 90 go to the scalar code
+			__m256d const valid = _mm256_cmp_pd( _mm256_and_pd( meanY, absMask ), maxLatitude, _CMP_LE_OQ );
+			if( _mm256_movemask_pd( valid ) != 0xF )
+				for( size_t j = i; j < i + 4; ++j )
+					oMeters[ j ] = SegmentMeters( iX[ j ], iY[ j ], iX[ j + 1 ], iY[ j + 1 ] );
+		}
+		for( ; i < segmentCount; ++i )
+			oMeters[ i ] = SegmentMeters( iX[ i ], iY[ i ], iX[ i + 1 ], iY[ i + 1 ] );
+	}
+
+	bool CpuHasAvx2() {
+		__builtin_cpu_init();
+		return __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" );
+	}
+#endif
+}
+
+//-------------------------------------------------------------------------
+bool gpx::HasSimdSegmentKernel()
+{
+#ifdef GPX_AVX2_KERNEL
+	static bool const hasAvx2 = CpuHasAvx2();
+	return hasAvx2;
+#else
+	return false;
+#endif
+}
+
+//-------------------------------------------------------------------------
+void gpx::SegmentDistancesScalar( double const * iX, double const * iY, size_t iCount, double * oMeters )
+{
+	for( size_t i = 0; i + 1 < iCount; ++i )
+		oMeters[ i ] = SegmentMeters( iX[ i ], iY[ i ], iX[ i + 1 ], iY[ i + 1 ] );
+}
+
+//-------------------------------------------------------------------------
+void gpx::SegmentDistances( double const * iX, double const * iY, size_t iCount, double * oMeters )
+{
+	if( iCount < 2 )
+		return;
+#ifdef GPX_AVX2_KERNEL
+	if( HasSimdSegmentKernel() ) {
+		SegmentDistancesAvx2( iX, iY, iCount, oMeters );
+		return;
+	}
+#endif
+	SegmentDistancesScalar( iX, iY, iCount, oMeters );
+}
+
+//-------------------------------------------------------------------------
+void gpx::SegmentSpeeds( double const * iMeters, time_t const * iTime, size_t iCount, double * oSpeeds )
+{
+	for( size_t i = 0; i + 1 < iCount; ++i )
+		oSpeeds[ i ] = SegmentSpeed( iMeters[ i ], iTime[ i ], iTime[ i + 1 ] );
+}
+
+//-------------------------------------------------------------------------
+void gpx::CalculateDistances( Track & ioTrack )
+{
+	ioTrack.distance.assign( ioTrack.size(), 0 );
+	SegmentDistances( ioTrack.x.data(), ioTrack.y.data(), ioTrack.size(), ioTrack.distance.data() );
+}
+
+//-------------------------------------------------------------------------
+template< typename TGeodesic >
+void gpx::FillSegmentSpeeds( Track & ioTrack, size_t iFirst, size_t iEnd )
+{
+	bool const cached = std::is_same< TGeodesic, Equirectangular >::value;
+	if( cached )
+		SegmentDistances( ioTrack.x.data() + iFirst, ioTrack.y.data() + iFirst, iEnd - iFirst + 1, ioTrack.distance.data() + iFirst );
+	for( size_t i = iFirst; i < iEnd; ++i ) {
+		if( ioTrack.speed[ i ] >= 0 )
+			continue;
+		double const meters = cached ? ioTrack.distance[ i ] : TGeodesic::Meters( ioTrack.x[ i ], ioTrack.y[ i ], ioTrack.x[ i + 1 ], ioTrack.y[ i + 1 ] );
+		ioTrack.speed[ i ] = SegmentSpeed( meters, ioTrack.time[ i ], ioTrack.time[ i + 1 ] );
+	}
+}
+
+template void gpx::FillSegmentSpeeds< gpx::Equirectangular >( Track &, size_t, size_t );
+template void gpx::FillSegmentSpeeds< gpx::Haversine >( Track &, size_t, size_t );
+template void gpx::FillSegmentSpeeds< gpx::Vincenty >( Track &, size_t, size_t );
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stddef.h>
+#include <time.h>
+
+struct Track;
+
+/**
+ * Whole track kernels for distances and speeds between neighbour positions.
+ *
+ * The formula is gpx::Equirectangular of Geodesy.h (equirectangular projection with cosine
+ * of the mean latitude). The AVX2 kernel is chosen at runtime when the CPU supports it,
+ * it evaluates cosine by a polynomial, so its distances differ from the scalar ones
+ * by less than SEGMENT_KERNEL_TOLERANCE (relative). Invalid latitudes (|y| > 90) are computed by the scalar code.
+ */
+namespace gpx
+{
+	double const SEGMENT_KERNEL_TOLERANCE = 1e-14;
+
+	/// oMeters[ i ] = distance in meters from position i to i + 1, iCount - 1 values are written.
+	void SegmentDistances( double const * iX, double const * iY, size_t iCount, double * oMeters );
+	/// Same as SegmentDistances, always the scalar code.
+	void SegmentDistancesScalar( double const * iX, double const * iY, size_t iCount, double * oMeters );
+	/// true when SegmentDistances uses SIMD on this CPU.
+	bool HasSimdSegmentKernel();
+
+	/// Speed in km/h of iMeters passed between iTime and iNextTime, the same as Position::CalculateSpeedByNext.
+	inline double SegmentSpeed( double iMeters, time_t iTime, time_t iNextTime ) {
+		time_t const timeInterval = iNextTime > iTime ? iNextTime - iTime : iTime - iNextTime;
+		return timeInterval ? iMeters * 3.6 / timeInterval : 0; // where 3.6 = ( 3600s / 1000m ), for speed in km / h
+	}
+
+	/// oSpeeds[ i ] = speed in km/h from position i to i + 1 by iMeters, iCount - 1 values are written.
+	void SegmentSpeeds( double const * iMeters, time_t const * iTime, size_t iCount, double * oSpeeds );
+
+	/// Fills ioTrack.distance cache: meters to the next position, 0 for the last one.
+	void CalculateDistances( Track & ioTrack );
+
+	/// Fills negative speeds of the segments [ iFirst, iEnd ) of @a ioTrack with the speeds by the distances of
+	/// the geodesic policy TGeodesic of Geodesy.h, instantiated for the policies there. gpx::Equirectangular distances
+	/// of the segments are written to the distance cache, which must have ioTrack.size() values; other policies
+	/// calculate only the distances of the negative speeds and don't touch the cache.
+	template< typename TGeodesic >
+	void FillSegmentSpeeds( Track & ioTrack, size_t iFirst, size_t iEnd );
+}
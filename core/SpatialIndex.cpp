@@ -0,0 +1,243 @@
+#include <math.h>
+#include <algorithm>
+#include "SpatialIndex.h"
+#include "Track.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+size_t const SEGMENTS_PER_CELL = 4;
+size_t const MAX_CELLS_PER_SEGMENT = 64; // longer segments go to SpatialIndex::m_longSegments
+size_t const MAX_CELL_COUNT = 1 << 22;
+
+//-------------------------------------------------------------------------
+void GeoBox::Add( double iX, double iY )
+{
+	if( IsEmpty() ) {
+		minX = maxX = iX;
+		minY = maxY = iY;
+		return;
+	}
+	minX = std::min( minX, iX );
+	maxX = std::max( maxX, iX );
+	minY = std::min( minY, iY );
+	maxY = std::max( maxY, iY );
+}
+
+//-------------------------------------------------------------------------
+GeoPolygon::GeoPolygon( std::vector< double > iX, std::vector< double > iY )
+	: m_x( std::move( iX ) )
+	, m_y( std::move( iY ) )
+{
+	m_y.resize( m_x.size() );
+	for( size_t i = 0; i < m_x.size(); ++i )
+		m_box.Add( m_x[ i ], m_y[ i ] );
+}
+
+//-------------------------------------------------------------------------
+GeoPolygon GeoPolygon::FromBox( GeoBox const & iBox )
+{
+	if( iBox.IsEmpty() )
+		return GeoPolygon();
+	return GeoPolygon( { iBox.minX, iBox.maxX, iBox.maxX, iBox.minX }, { iBox.minY, iBox.minY, iBox.maxY, iBox.maxY } );
+}
+
+//-------------------------------------------------------------------------
+bool GeoPolygon::Contains( double iX, double iY ) const
+{
+	if( m_x.size() < 3 || iX < m_box.minX || iX > m_box.maxX || iY < m_box.minY || iY > m_box.maxY )
+		return false;
+	// even-odd rule: count crossings of the edges with the ray to the right of the point
+	bool inside = false;
+	for( size_t i = 0, j = m_x.size() - 1; i < m_x.size(); j = i++ ) {
+		if( ( m_y[ i ] > iY ) != ( m_y[ j ] > iY ) &&
+				iX < ( m_x[ j ] - m_x[ i ] ) * ( iY - m_y[ i ] ) / ( m_y[ j ] - m_y[ i ] ) + m_x[ i ] )
+			inside = !inside;
+	}
+	return inside;
+}
+
+//-------------------------------------------------------------------------
+/// Calls @a iOnInside( s0, s1 ) for every part of segment a-b inside the polygon, s is 0 at a and 1 at b.
+/// @a ioBorders is a buffer reused by calls.
+template< typename TOnInside >
+void ClipSegment( GeoPolygon const & iArea, double iAX, double iAY, double iBX, double iBY, std::vector< double > & ioBorders, TOnInside const & iOnInside )
+{
+	GeoBox segmentBox;
+	segmentBox.Add( iAX, iAY );
+	segmentBox.Add( iBX, iBY );
+	if( !segmentBox.Intersects( iArea.Box() ) )
+		return;
+
+	double const dx = iBX - iAX;
+	double const dy = iBY - iAY;
+	if( dx == 0 && dy == 0 ) { // standing still
+		if( iArea.Contains( iAX, iAY ) )
+			iOnInside( 0.0, 1.0 );
+		return;
+	}
+
+	// the segment crosses the border only at intersections with edges, between them it is either inside or outside
+	std::vector< double > & borders = ioBorders;
+	borders.assign( 1, 0.0 );
+	for( size_t i = 0, j = iArea.size() - 1; i < iArea.size(); j = i++ ) {
+		double const ex = iArea.x( i ) - iArea.x( j );
+		double const ey = iArea.y( i ) - iArea.y( j );
+		double const denominator = dx * ey - dy * ex;
+		if( denominator == 0 )
+			continue; // parallel edge, the midpoint test below handles it
+		double const wx = iArea.x( j ) - iAX;
+		double const wy = iArea.y( j ) - iAY;
+		double const s = ( wx * ey - wy * ex ) / denominator;  // on the segment
+		double const u = ( wx * dy - wy * dx ) / denominator;  // on the edge
+		if( s > 0 && s < 1 && u >= 0 && u <= 1 )
+			borders.push_back( s );
+	}
+	borders.push_back( 1.0 );
+	std::sort( borders.begin(), borders.end() );
+
+	for( size_t i = 0; i + 1 < borders.size(); ++i ) {
+		double const s0 = borders[ i ];
+		double const s1 = borders[ i + 1 ];
+		if( s1 <= s0 )
+			continue;
+		double const middle = ( s0 + s1 ) / 2;
+		if( iArea.Contains( iAX + dx * middle, iAY + dy * middle ) )
+			iOnInside( s0, s1 );
+	}
+}
+
+//-------------------------------------------------------------------------
+SpatialIndex::SpatialIndex( std::shared_ptr< Track const > iTrack )
+	: m_track( std::move( iTrack ) )
+{
+	ProfileScope const scope( "SpatialIndex" );
+	if( m_track == nullptr || m_track->size() < 2 )
+		return;
+	Track const & track = *m_track;
+	for( size_t i = 0; i < track.size(); ++i )
+		m_box.Add( track.x[ i ], track.y[ i ] );
+
+	// about SEGMENTS_PER_CELL segments per cell, cells follow the shape of the box
+	size_t const segmentCount = track.size() - 1;
+	double const width = std::max( m_box.maxX - m_box.minX, 1e-9 );
+	double const height = std::max( m_box.maxY - m_box.minY, 1e-9 );
+	double const cellCount = double( std::min( std::max< size_t >( segmentCount / SEGMENTS_PER_CELL, 1 ), MAX_CELL_COUNT ) );
+	double const cellSide = sqrt( width * height / cellCount );
+	m_columns = uint32_t( std::min( std::max( ceil( width / cellSide ), 1.0 ), cellCount ) );
+	m_rows = uint32_t( std::min( std::max( ceil( height / cellSide ), 1.0 ), cellCount ) );
+	m_cellWidth = width / m_columns;
+	m_cellHeight = height / m_rows;
+
+	// two passes: count segments per cell, then place them, every cell gets a contiguous range
+	auto const cellRange = [&]( size_t iSegment, uint32_t & oX0, uint32_t & oX1, uint32_t & oY0, uint32_t & oY1 ) {
+		auto const column = [&]( double iX ) { return uint32_t( std::min( ( iX - m_box.minX ) / m_cellWidth, m_columns - 1.0 ) ); };
+		auto const row = [&]( double iY ) { return uint32_t( std::min( ( iY - m_box.minY ) / m_cellHeight, m_rows - 1.0 ) ); };
+		oX0 = column( std::min( track.x[ iSegment ], track.x[ iSegment + 1 ] ) );
+		oX1 = column( std::max( track.x[ iSegment ], track.x[ iSegment + 1 ] ) );
+		oY0 = row( std::min( track.y[ iSegment ], track.y[ iSegment + 1 ] ) );
+		oY1 = row( std::max( track.y[ iSegment ], track.y[ iSegment + 1 ] ) );
+		return size_t( oX1 - oX0 + 1 ) * ( oY1 - oY0 + 1 ) <= MAX_CELLS_PER_SEGMENT;
+	};
+	m_cellStart.assign( size_t( m_columns ) * m_rows + 1, 0 );
+	uint32_t x0, x1, y0, y1;
+	for( size_t i = 0; i < segmentCount; ++i ) {
+		if( !cellRange( i, x0, x1, y0, y1 ) )
+			continue;
+		for( uint32_t y = y0; y <= y1; ++y )
+			for( uint32_t x = x0; x <= x1; ++x )
+				++m_cellStart[ size_t( y ) * m_columns + x + 1 ];
+	}
+	for( size_t c = 1; c < m_cellStart.size(); ++c )
+		m_cellStart[ c ] += m_cellStart[ c - 1 ];
+
+	m_segments.resize( m_cellStart.back() );
+	std::vector< uint32_t > fill( m_cellStart.begin(), m_cellStart.end() - 1 );
+	for( size_t i = 0; i < segmentCount; ++i ) {
+		if( !cellRange( i, x0, x1, y0, y1 ) ) {
+			m_longSegments.push_back( uint32_t( i ) );
+			continue;
+		}
+		for( uint32_t y = y0; y <= y1; ++y )
+			for( uint32_t x = x0; x <= x1; ++x )
+				m_segments[ fill[ size_t( y ) * m_columns + x ]++ ] = uint32_t( i );
+	}
+}
+
+//-------------------------------------------------------------------------
+void SpatialIndex::AddCandidates( GeoBox const & iArea, std::vector< uint32_t > & oSegments ) const
+{
+	if( !m_box.Intersects( iArea ) )
+		return;
+	auto const clamp = []( double iValue, uint32_t iCount ) { return uint32_t( std::min( std::max( iValue, 0.0 ), iCount - 1.0 ) ); };
+	uint32_t const x0 = clamp( ( iArea.minX - m_box.minX ) / m_cellWidth, m_columns );
+	uint32_t const x1 = clamp( ( iArea.maxX - m_box.minX ) / m_cellWidth, m_columns );
+	uint32_t const y0 = clamp( ( iArea.minY - m_box.minY ) / m_cellHeight, m_rows );
+	uint32_t const y1 = clamp( ( iArea.maxY - m_box.minY ) / m_cellHeight, m_rows );
+	for( uint32_t y = y0; y <= y1; ++y ) {
+		size_t const row = size_t( y ) * m_columns;
+		oSegments.insert( oSegments.end(), m_segments.begin() + m_cellStart[ row + x0 ], m_segments.begin() + m_cellStart[ row + x1 + 1 ] );
+	}
+	oSegments.insert( oSegments.end(), m_longSegments.begin(), m_longSegments.end() );
+	// a segment is in every cell it touches
+	std::sort( oSegments.begin(), oSegments.end() );
+	oSegments.erase( std::unique( oSegments.begin(), oSegments.end() ), oSegments.end() );
+}
+
+//-------------------------------------------------------------------------
+std::vector< TimeInterval > SpatialIndex::Inside( GeoPolygon const & iArea ) const
+{
+	std::vector< TimeInterval > result;
+	if( m_track == nullptr || iArea.size() < 3 )
+		return result;
+	std::vector< uint32_t > candidates;
+	AddCandidates( iArea.Box(), candidates );
+
+	Track const & track = *m_track;
+	std::vector< double > borders;
+	for( uint32_t segment: candidates ) {
+		double const start = double( track.time[ segment ] );
+		double const duration = double( track.time[ segment + 1 ] - track.time[ segment ] );
+		ClipSegment( iArea, track.x[ segment ], track.y[ segment ], track.x[ segment + 1 ], track.y[ segment + 1 ], borders, [&]( double iS0, double iS1 ) {
+			TimeInterval const interval = { start + iS0 * duration, start + iS1 * duration };
+			if( !result.empty() && result.back().end >= interval.begin )
+				result.back().end = std::max( result.back().end, interval.end ); // continues through the next segment
+			else
+				result.push_back( interval );
+		} );
+	}
+	return result;
+}
+
+//-------------------------------------------------------------------------
+std::vector< TimeInterval > SpatialIndex::Inside( GeoBox const & iArea ) const
+{
+	return Inside( GeoPolygon::FromBox( iArea ) );
+}
+
+//-------------------------------------------------------------------------
+double SpatialIndex::InsideDuration( GeoPolygon const & iArea ) const
+{
+	double result = 0;
+	for( TimeInterval const & interval: Inside( iArea ) )
+		result += interval.end - interval.begin;
+	return result;
+}
+
+//-------------------------------------------------------------------------
+bool SpatialIndex::PassesThrough( GeoBox const & iArea ) const
+{
+	return !Inside( iArea ).empty();
+}
+
+//#########################################################################
+//---------------------------- Namespace gpx ------------------------------
+//#########################################################################
+std::vector< double > gpx::InsideDurations( std::vector< SpatialIndex > const & iTracks, std::vector< GeoPolygon > const & iAreas, ThreadPool & ioPool )
+{
+	std::vector< double > result( iTracks.size() * iAreas.size(), 0.0 );
+	ioPool.ForEach( iTracks.size(), [&]( size_t t ) {
+		for( size_t a = 0; a < iAreas.size(); ++a )
+			result[ t * iAreas.size() + a ] = iTracks[ t ].InsideDuration( iAreas[ a ] );
+	} );
+	return result;
+}
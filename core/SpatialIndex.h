@@ -0,0 +1,103 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <stdint.h>
+
+struct Track;
+class ThreadPool;
+
+/// Rectangle in degrees, x - longitude, y - latitude.
+struct GeoBox
+{
+	double minX = 0;
+	double minY = 0;
+	double maxX = -1; // empty
+	double maxY = -1;
+
+	bool IsEmpty() const { return maxX < minX || maxY < minY; }
+	bool Intersects( GeoBox const & iBox ) const
+	{
+		return !IsEmpty() && !iBox.IsEmpty() && minX <= iBox.maxX && iBox.minX <= maxX && minY <= iBox.maxY && iBox.minY <= maxY;
+	}
+	void Add( double iX, double iY );
+};
+
+/**
+ * @class GeoPolygon is a closed polygon in degrees, the even-odd rule defines its inside.
+ *
+ * Coordinates are treated as planar, that is exact enough for geofences of a city size.
+ */
+class GeoPolygon
+{
+public:
+	GeoPolygon() = default;
+	GeoPolygon( std::vector< double > iX, std::vector< double > iY );
+	static GeoPolygon FromBox( GeoBox const & iBox );
+
+	bool Contains( double iX, double iY ) const;
+	GeoBox const & Box() const { return m_box; }
+	size_t size() const { return m_x.size(); }
+	double x( size_t iIndex ) const { return m_x[ iIndex ]; }
+	double y( size_t iIndex ) const { return m_y[ iIndex ]; }
+
+private:
+	std::vector< double > m_x;
+	std::vector< double > m_y;
+	GeoBox                m_box;
+};
+
+/// Time range in seconds since the epoch, fractional as borders are interpolated on segments.
+struct TimeInterval
+{
+	double begin;
+	double end;
+};
+
+/**
+ * @class SpatialIndex answers geofence queries over one track without a scan of all its positions.
+ *
+ * Segments between consecutive positions are bucketed into a uniform grid over the bounding box of the track
+ * (about SEGMENTS_PER_CELL segments per cell, stored as one array with cell offsets). A query visits only the
+ * cells under the bounding box of the area. Segments covering many cells (jumps over gaps) are kept
+ * in a separate list checked by every query, so they don't blow the grid up.
+ * The position moves linearly in time along a segment, so borders of the intervals are interpolated.
+ */
+class SpatialIndex
+{
+public:
+	SpatialIndex() = default;
+	explicit SpatialIndex( std::shared_ptr< Track const > iTrack );
+
+	std::shared_ptr< Track const > const & GetTrack() const { return m_track; }
+	GeoBox const & Box() const { return m_box; }
+
+	/// Intervals when the track is inside @a iArea, ordered and not touching each other.
+	std::vector< TimeInterval > Inside( GeoPolygon const & iArea ) const;
+	std::vector< TimeInterval > Inside( GeoBox const & iArea ) const;
+
+	/// Seconds inside @a iArea.
+	double InsideDuration( GeoPolygon const & iArea ) const;
+	bool PassesThrough( GeoBox const & iArea ) const;
+
+private:
+	void AddCandidates( GeoBox const & iArea, std::vector< uint32_t > & oSegments ) const;
+
+private:
+	std::shared_ptr< Track const > m_track;
+	GeoBox                  m_box;
+	double                  m_cellWidth = 1;
+	double                  m_cellHeight = 1;
+	uint32_t                m_columns = 0;
+	uint32_t                m_rows = 0;
+	std::vector< uint32_t > m_cellStart;    /// segments of cell c are m_segments[ m_cellStart[ c ], m_cellStart[ c + 1 ] )
+	std::vector< uint32_t > m_segments;     /// segment i goes from position i to i + 1
+	std::vector< uint32_t > m_longSegments; /// segments covering too many cells to be put into them
+};
+
+namespace gpx
+{
+	/// Seconds every track spends inside every area, result[ track * iAreas.size() + area ].
+	/// Tracks are processed in parallel by @a ioPool.
+	std::vector< double > InsideDurations( std::vector< SpatialIndex > const & iTracks, std::vector< GeoPolygon > const & iAreas, ThreadPool & ioPool );
+}
@@ -0,0 +1,65 @@
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include "Track.h"
+#include "SpeedIndex.h"
+#include "Profiler.h"
+
+//-------------------------------------------------------------------------
+SpeedIndex::SpeedIndex( Track const & iTrack )
+{
+	ProfileScope const scope( "SpeedIndex" );
+	m_valid = m_info.calculate( iTrack, std::numeric_limits< float >::infinity() );
+	if( !m_valid )
+		return;
+
+	std::vector< std::pair< double, long > > segments; // < speed, duration > of driving segments
+	double previousSpeed = -1;
+	for( size_t i = 0; i + 1 < iTrack.size(); ++i ) {
+		double const speed = iTrack.speed[ i ];
+		if( speed <= 0 )
+			continue; // idle segments neither count nor break over speed runs
+		segments.emplace_back( speed, long( iTrack.time[ i + 1 ] - iTrack.time[ i ] ) );
+		if( previousSpeed > 0 )
+			m_runContinuations.push_back( std::min( speed, previousSpeed ) );
+		previousSpeed = speed;
+	}
+
+	std::sort( segments.begin(), segments.end() );
+	std::sort( m_runContinuations.begin(), m_runContinuations.end() );
+
+	m_speeds.resize( segments.size() );
+	m_durationsAbove.assign( segments.size() + 1, 0 );
+	for( size_t i = segments.size(); i-- > 0; ) {
+		m_speeds[ i ] = segments[ i ].first;
+		m_durationsAbove[ i ] = m_durationsAbove[ i + 1 ] + segments[ i ].second;
+	}
+}
+
+//-------------------------------------------------------------------------
+long SpeedIndex::OverSpeedDuration( float iSpeedLimit ) const
+{
+	size_t const firstOver = std::upper_bound( m_speeds.begin(), m_speeds.end(), double( iSpeedLimit ) ) - m_speeds.begin();
+	return m_durationsAbove.empty() ? 0 : m_durationsAbove[ firstOver ];
+}
+
+//-------------------------------------------------------------------------
+int SpeedIndex::OverSpeedCount( float iSpeedLimit ) const
+{
+	double const limit = iSpeedLimit;
+	auto const overSegments = m_speeds.end() - std::upper_bound( m_speeds.begin(), m_speeds.end(), limit );
+	auto const overContinuations = m_runContinuations.end() - std::upper_bound( m_runContinuations.begin(), m_runContinuations.end(), limit );
+	return int( overSegments - overContinuations );
+}
+
+//-------------------------------------------------------------------------
+bool SpeedIndex::Calculate( float iSpeedLimit, TrackInfo & oInfo ) const
+{
+	if( !m_valid )
+		return false;
+	oInfo = m_info;
+	oInfo.speedLimit = iSpeedLimit;
+	oInfo.overSpeedDuration = OverSpeedDuration( iSpeedLimit );
+	oInfo.overSpeedCount = OverSpeedCount( iSpeedLimit );
+	return true;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+#include "TrackInfo.h"
+
+struct Track;
+
+/**
+ * @class SpeedIndex answers TrackInfo for any speed limit without a scan of the track.
+ *
+ * Built once per track: the limit independent statistics are kept as is, the driving segments
+ * are sorted by speed with suffix sums of their durations, so over speed duration is a binary search.
+ * An over speed run starts at a driving segment faster than the limit when the previous driving
+ * segment isn't (idle segments don't break a run, like in TrackInfo::calculate), so
+ * runs = #{ speed > limit } - #{ min( speed, previous driving speed ) > limit }, two binary searches more.
+ */
+class SpeedIndex
+{
+public:
+	SpeedIndex() = default;
+	explicit SpeedIndex( Track const & iTrack );
+
+	/// false when the track has negative speed, TrackInfo::calculate fails for such tracks.
+	bool IsValid() const { return m_valid; }
+
+	long OverSpeedDuration( float iSpeedLimit ) const;
+	int  OverSpeedCount( float iSpeedLimit ) const;
+
+	/// The same result as TrackInfo::calculate( track, iSpeedLimit ) in O( log n ).
+	bool Calculate( float iSpeedLimit, TrackInfo & oInfo ) const;
+
+private:
+	bool                  m_valid = true;
+	TrackInfo             m_info;            /// limit independent part of the track info
+	std::vector< double > m_speeds;          /// speeds of driving segments, ascending
+	std::vector< long >   m_durationsAbove;  /// m_durationsAbove[ i ] = duration of m_speeds[ i.. ] segments, one more 0 at the end
+	std::vector< double > m_runContinuations; /// min( speed, previous driving speed ) for driving segments, ascending
+};
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include "SpeedPyramid.h"
+
+//-------------------------------------------------------------------------
+void SpeedPyramid::Build( std::vector< double > const & iSpeeds )
+{
+	m_levels.clear();
+	Update( iSpeeds, 0 );
+}
+
+//-------------------------------------------------------------------------
+void SpeedPyramid::Update( std::vector< double > const & iSpeeds, size_t iFirstChanged )
+{
+	// entries of a level from first / 2 on depend on changed children, the rest is kept
+	size_t size = iSpeeds.size();
+	size_t first = iFirstChanged;
+	size_t levelCount = 0;
+	for( ; size > 1; ++levelCount ) {
+		size_t const parentSize = ( size + 1 ) / 2;
+		if( levelCount == m_levels.size() )
+			m_levels.emplace_back();
+		Level & level = m_levels[ levelCount ];
+		first = std::min( first / 2, level.min.size() );
+		level.min.resize( parentSize );
+		level.max.resize( parentSize );
+		for( size_t i = first; i < parentSize; ++i ) {
+			size_t const left = 2 * i;
+			size_t const right = std::min( left + 1, size - 1 );
+			if( levelCount == 0 ) {
+				level.min[ i ] = float( std::min( iSpeeds[ left ], iSpeeds[ right ] ) );
+				level.max[ i ] = float( std::max( iSpeeds[ left ], iSpeeds[ right ] ) );
+			} else {
+				Level const & child = m_levels[ levelCount - 1 ];
+				level.min[ i ] = std::min( child.min[ left ], child.min[ right ] );
+				level.max[ i ] = std::max( child.max[ left ], child.max[ right ] );
+			}
+		}
+		size = parentSize;
+	}
+	m_levels.resize( levelCount );
+}
+
+//-------------------------------------------------------------------------
+void SpeedPyramid::Clear()
+{
+	m_levels.clear();
+}
+
+//-------------------------------------------------------------------------
+void SpeedPyramid::Range( std::vector< double > const & iSpeeds, size_t iBegin, size_t iEnd, double & oMin, double & oMax ) const
+{
+	// [ begin, end ) of the current level, odd borders are taken from the level and the rest moves one level up
+	oMin = iSpeeds[ iBegin ];
+	oMax = iSpeeds[ iBegin ];
+	size_t begin = iBegin;
+	size_t end = iEnd;
+	for( size_t level = 0; begin < end; ++level ) {
+		auto const take = [&]( size_t iIndex ) {
+			if( level == 0 ) {
+				oMin = std::min( oMin, iSpeeds[ iIndex ] );
+				oMax = std::max( oMax, iSpeeds[ iIndex ] );
+			} else {
+				oMin = std::min( oMin, double( m_levels[ level - 1 ].min[ iIndex ] ) );
+				oMax = std::max( oMax, double( m_levels[ level - 1 ].max[ iIndex ] ) );
+			}
+		};
+		if( begin & 1 )
+			take( begin++ );
+		if( end & 1 )
+			take( --end );
+		begin /= 2;
+		end /= 2;
+	}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vector>
+#include <stddef.h>
+
+/**
+ * @class SpeedPyramid is a multi-resolution min/max envelope of track speeds.
+ *
+ * Level k keeps min and max speed of every 2^k consecutive positions (level 0 is the speed column itself),
+ * so min and max of any range of positions is found in O( log n ) by taking the largest aligned blocks.
+ * It lets a graph draw one primitive per pixel column whatever the number of positions under it.
+ */
+class SpeedPyramid
+{
+public:
+	void Build( std::vector< double > const & iSpeeds );
+	/// Brings the pyramid up to date after iSpeeds[ iFirstChanged.. ] were changed, appended or removed,
+	/// O( changed positions + log n ), so a growing track is followed without a rebuild.
+	void Update( std::vector< double > const & iSpeeds, size_t iFirstChanged );
+	void Clear();
+
+	/// Min and max of iSpeeds[ iBegin, iEnd ), iSpeeds is the column the pyramid was built for, iBegin < iEnd.
+	void Range( std::vector< double > const & iSpeeds, size_t iBegin, size_t iEnd, double & oMin, double & oMax ) const;
+
+private:
+	struct Level
+	{
+		std::vector< float > min;
+		std::vector< float > max;
+	};
+	std::vector< Level > m_levels; /// m_levels[ k - 1 ] is level k
+};
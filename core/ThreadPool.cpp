@@ -0,0 +1,181 @@
+#include <atomic>
+#include <algorithm>
+#include "ThreadPool.h"
+
+namespace
+{
+	/// Index of the current worker in its pool, used to keep nested tasks local.
+	thread_local ThreadPool const * g_currentPool = nullptr;
+	thread_local unsigned g_currentWorker = 0;
+}
+
+//-------------------------------------------------------------------------
+ThreadPool::ThreadPool( unsigned iThreadCount )
+	: m_queuedCount( 0 )
+	, m_pendingCount( 0 )
+	, m_nextQueue( 0 )
+	, m_stop( false )
+{
+	unsigned const threadCount = iThreadCount ? iThreadCount : std::max( std::thread::hardware_concurrency(), 1u );
+	m_queues.reserve( threadCount );
+	for( unsigned i = 0; i < threadCount; ++i )
+		m_queues.emplace_back( new TaskQueue );
+	m_workers.reserve( threadCount );
+	for( unsigned i = 0; i < threadCount; ++i )
+		m_workers.emplace_back( &ThreadPool::WorkerLoop, this, i );
+}
+
+//-------------------------------------------------------------------------
+ThreadPool::~ThreadPool()
+{
+	{
+		std::unique_lock< std::mutex > lock( m_mutex );
+		m_allDone.wait( lock, [this] { return m_pendingCount == 0; } );
+		m_stop = true;
+	}
+	m_taskAdded.notify_all();
+	for( std::thread & worker: m_workers )
+		worker.join();
+}
+
+//-------------------------------------------------------------------------
+void ThreadPool::Submit( TTask iTask )
+{
+	unsigned queue;
+	{
+		std::lock_guard< std::mutex > lock( m_mutex );
+		// counted before it's queued, so a worker never sees the counter lower than the queues
+		++m_queuedCount;
+		++m_pendingCount;
+		queue = g_currentPool == this ? g_currentWorker : m_nextQueue++ % m_queues.size();
+	}
+	{
+		std::lock_guard< std::mutex > lock( m_queues[ queue ]->mutex );
+		m_queues[ queue ]->tasks.push_back( std::move( iTask ) );
+	}
+	m_taskAdded.notify_one();
+}
+
+//-------------------------------------------------------------------------
+void ThreadPool::Wait()
+{
+	std::exception_ptr error;
+	{
+		std::unique_lock< std::mutex > lock( m_mutex );
+		m_allDone.wait( lock, [this] { return m_pendingCount == 0; } );
+		std::swap( error, m_error );
+	}
+	if( error )
+		std::rethrow_exception( error );
+}
+
+//-------------------------------------------------------------------------
+void ThreadPool::ForEach( size_t iCount, std::function< void( size_t ) > iTask )
+{
+	if( iCount == 0 )
+		return;
+	// Indices are claimed by the calling thread and the pool tasks in turn, the caller waits only for the claimed ones.
+	// So a pool busy with other work (or the pool running the caller) can't block the call,
+	// and a late task finds nothing to claim and doesn't touch the data of the finished call.
+	struct Claims
+	{
+		std::function< void( size_t ) > task;
+		size_t                          count;
+		std::atomic< size_t >           next{ 0 };
+		std::mutex                      mutex;
+		std::condition_variable         allDone;
+		size_t                          done = 0; /// guarded by mutex
+		std::exception_ptr              error;    /// guarded by mutex
+	};
+	auto const claims = std::make_shared< Claims >();
+	claims->task = std::move( iTask );
+	claims->count = iCount;
+	TTask const runClaimed = [claims] {
+		for( size_t index; ( index = claims->next.fetch_add( 1 ) ) < claims->count; ) {
+			std::exception_ptr error;
+			try {
+				claims->task( index );
+			} catch( ... ) {
+				error = std::current_exception();
+			}
+			std::lock_guard< std::mutex > lock( claims->mutex );
+			if( error && !claims->error )
+				claims->error = error;
+			if( ++claims->done == claims->count )
+				claims->allDone.notify_all();
+		}
+	};
+	// every task claims indices until none is left, so more tasks than workers would only be idle
+	for( size_t i = 1, taskCount = std::min( iCount, m_workers.size() + 1 ); i < taskCount; ++i )
+		Submit( runClaimed );
+	runClaimed();
+
+	std::unique_lock< std::mutex > lock( claims->mutex );
+	claims->allDone.wait( lock, [&] { return claims->done == claims->count; } );
+	if( claims->error )
+		std::rethrow_exception( claims->error );
+}
+
+//-------------------------------------------------------------------------
+bool ThreadPool::TakeTask( unsigned iWorker, TTask & oTask )
+{
+	// own tasks are taken LIFO (hot in cache), stolen ones FIFO (the oldest, usually the biggest)
+	{
+		TaskQueue & own = *m_queues[ iWorker ];
+		std::lock_guard< std::mutex > lock( own.mutex );
+		if( !own.tasks.empty() ) {
+			oTask = std::move( own.tasks.back() );
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+	for( size_t i = 1; i < m_queues.size(); ++i ) {
+		TaskQueue & victim = *m_queues[ ( iWorker + i ) % m_queues.size() ];
+		std::lock_guard< std::mutex > lock( victim.mutex );
+		if( !victim.tasks.empty() ) {
+			oTask = std::move( victim.tasks.front() );
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+//-------------------------------------------------------------------------
+void ThreadPool::WorkerLoop( unsigned iWorker )
+{
+	g_currentPool = this;
+	g_currentWorker = iWorker;
+
+	while( true ) {
+		TTask task;
+		if( !TakeTask( iWorker, task ) ) {
+			std::unique_lock< std::mutex > lock( m_mutex );
+			if( m_queuedCount == 0 ) {
+				if( m_stop )
+					return;
+				m_taskAdded.wait( lock, [this] { return m_stop || m_queuedCount > 0; } );
+			}
+			continue; // the task may still be on the way to its queue, try again
+		}
+
+		{
+			std::lock_guard< std::mutex > lock( m_mutex );
+			--m_queuedCount;
+		}
+
+		std::exception_ptr error;
+		try {
+			task();
+		} catch( ... ) {
+			error = std::current_exception();
+		}
+		task = nullptr; // release captured data before the task is reported as done
+
+		std::lock_guard< std::mutex > lock( m_mutex );
+		if( error && !m_error )
+			m_error = error;
+		if( --m_pendingCount == 0 )
+			m_allDone.notify_all();
+	}
+}
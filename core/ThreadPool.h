@@ -0,0 +1,66 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+/**
+ * @class ThreadPool is a fixed set of worker threads with work stealing.
+ *
+ * Every worker has its own task deque. A worker takes tasks from the back of its own deque
+ * and steals from the front of the others when its deque is empty. Tasks submitted by a worker
+ * go to its own deque, other tasks are spread round-robin.
+ */
+class ThreadPool
+{
+public:
+	typedef std::function< void() > TTask;
+
+	/// @a iThreadCount 0 - as many threads as cores.
+	explicit ThreadPool( unsigned iThreadCount = 0 );
+	~ThreadPool(); /// waits all submitted tasks
+
+	ThreadPool( ThreadPool const & ) = delete;
+	ThreadPool & operator=( ThreadPool const & ) = delete;
+
+	void Submit( TTask iTask );
+
+	/// Calls @a iTask for every index below @a iCount on the pool threads and the calling thread,
+	/// returns when these calls are done and rethrows the first exception thrown by them.
+	/// Unlike Wait it doesn't wait for other tasks of the pool, so it may be called from a task.
+	void ForEach( size_t iCount, std::function< void( size_t ) > iTask );
+
+	/// Blocks until all submitted tasks are done, rethrows the first exception thrown by a task.
+	void Wait();
+
+	unsigned ThreadCount() const { return unsigned( m_workers.size() ); }
+
+private: // types
+	struct TaskQueue
+	{
+		std::mutex          mutex;
+		std::deque< TTask > tasks;
+	};
+
+private: // helpers
+	void WorkerLoop( unsigned iWorker );
+	bool TakeTask( unsigned iWorker, TTask & oTask );
+
+private: // members
+	std::vector< std::unique_ptr< TaskQueue > > m_queues;  /// one per worker
+	std::vector< std::thread >                  m_workers;
+
+	std::mutex              m_mutex;          /// guards the members below
+	std::condition_variable m_taskAdded;
+	std::condition_variable m_allDone;
+	size_t                  m_queuedCount;    /// tasks in queues
+	size_t                  m_pendingCount;   /// tasks submitted but not finished
+	unsigned                m_nextQueue;      /// round-robin queue for tasks from outside
+	bool                    m_stop;
+	std::exception_ptr      m_error;          /// first exception thrown by a task
+};
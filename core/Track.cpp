@@ -0,0 +1,60 @@
+#include "Track.h"
+
+//-------------------------------------------------------------------------
+void Track::clear()
+{
+	x.clear();
+	y.clear();
+	time.clear();
+	speed.clear();
+	distance.clear();
+	extraColumns.clear();
+}
+
+//-------------------------------------------------------------------------
+void Track::reserve( size_t iSize )
+{
+	x.reserve( iSize );
+	y.reserve( iSize );
+	time.reserve( iSize );
+	speed.reserve( iSize );
+}
+
+//-------------------------------------------------------------------------
+size_t Track::memoryUsage() const
+{
+	size_t result = ( x.capacity() + y.capacity() + speed.capacity() + distance.capacity() ) * sizeof( double ) + time.capacity() * sizeof( time_t );
+	for( auto const & extra: extraColumns )
+		result += extra.second.capacity() * sizeof( double );
+	return result;
+}
+
+//-------------------------------------------------------------------------
+void Track::push_back( Position const & iPos )
+{
+	x.push_back( iPos.x );
+	y.push_back( iPos.y );
+	time.push_back( iPos.time );
+	speed.push_back( iPos.speed );
+	distance.clear();
+}
+
+//-------------------------------------------------------------------------
+Track Track::FromPositions( std::vector< Position > const & iPositions )
+{
+	Track result;
+	result.reserve( iPositions.size() );
+	for( Position const & pos: iPositions )
+		result.push_back( pos );
+	return result;
+}
+
+//-------------------------------------------------------------------------
+std::vector< Position > Track::ToPositions() const
+{
+	std::vector< Position > result;
+	result.reserve( size() );
+	for( size_t i = 0; i < size(); ++i )
+		result.push_back( position( i ) );
+	return result;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "MGpxTools.h"
+
+/**
+ * @struct Track is a columnar storage of track positions.
+ *
+ * Every field of Position lives in its own contiguous array, so a scan over speed or time
+ * streams through cache and doesn't drag coordinates along. All columns have size() elements.
+ */
+struct Track
+{
+	size_t size() const { return time.size(); }
+	bool empty() const { return time.empty(); }
+	void clear();
+	void reserve( size_t iSize );
+	/// Bytes held by the columns, the distance cache and extra columns included.
+	size_t memoryUsage() const;
+
+	void push_back( Position const & iPos );
+	Position position( size_t iIndex ) const {
+		Position result( x[ iIndex ], y[ iIndex ], time[ iIndex ] );
+		result.speed = speed[ iIndex ]; // the constructor takes float
+		return result;
+	}
+
+	/// Compatibility with code working with positions.
+	static Track FromPositions( std::vector< Position > const & iPositions );
+	std::vector< Position > ToPositions() const;
+
+	std::vector< double > x;     /// longitude
+	std::vector< double > y;     /// latitude
+	std::vector< time_t > time;
+	std::vector< double > speed; /// km/h on the way to the next position
+
+	/// Cache of meters to the next position (0 for the last one), filled by gpx::CalculateDistances.
+	/// Empty when not calculated, any change of the track clears it. Always the gpx::Equirectangular distances,
+	/// tracks of other geodesic policies don't fill it.
+	std::vector< double > distance;
+
+	/// Optional columns by name, a column is either absent or has size() values.
+	std::map< std::string, std::vector< double > > extraColumns;
+};
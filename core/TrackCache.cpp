@@ -0,0 +1,273 @@
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <cctype>
+#include <cstdio>
+#include <atomic>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <string_view>
+#include "TrackCache.h"
+#include "Track.h"
+#include "MappedFile.h"
+#include "Profiler.h"
+
+#if defined( _WIN32 )
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+// --------------------------------------------------------------------------------------
+// Cache file layout, all values are in the native byte order and 8 bytes aligned:
+//   CacheHeader
+//   x, y, time, speed [, distance] columns of CacheHeader::count 8 byte values
+//   extraCount times: name size, name padded to 8 bytes, CacheHeader::count doubles
+// The cache belongs to the GPX file with the same size, modification time and sampled hash,
+// a cache of another file version or of other processing options is ignored and rewritten.
+// --------------------------------------------------------------------------------------
+char const CACHE_MAGIC[ 8 ] = { 'G', 'P', 'X', 'C', 'A', 'C', 'H', 'E' };
+uint32_t const CACHE_VERSION = 2;
+uint32_t const CACHE_BYTE_ORDER = 0x01020304;
+uint64_t const CACHE_HAS_DISTANCE = 1; // CacheHeader::flags bit
+
+size_t const HASH_SAMPLE_COUNT = 16;
+size_t const HASH_SAMPLE_SIZE = 4096;
+
+struct CacheHeader
+{
+	char     magic[ 8 ];
+	uint32_t version;
+	uint32_t byteOrder;
+	uint64_t sourceSize;
+	int64_t  sourceTime;  /// modification time of the GPX file, file clock ticks
+	uint64_t sourceHash;  /// see SampledHash
+	uint64_t count;       /// positions in the track
+	uint64_t flags;
+	uint64_t extraCount;  /// Track::extraColumns
+	uint64_t processing;  /// processing key of the track, see gpx::ReadTrackCache
+};
+
+//-------------------------------------------------------------------------
+/// FNV-1a of HASH_SAMPLE_COUNT blocks spread over the data, the first and the last ones included.
+/// It catches a file rewritten with the same size and time without reading the whole file.
+uint64_t SampledHash( std::string_view iData )
+{
+	uint64_t hash = 14695981039346656037ull;
+	size_t const step = iData.size() > HASH_SAMPLE_SIZE ? ( iData.size() - HASH_SAMPLE_SIZE ) / ( HASH_SAMPLE_COUNT - 1 ) : 0;
+	for( size_t i = 0; i < HASH_SAMPLE_COUNT; ++i ) {
+		std::string_view const sample = iData.substr( i * step, HASH_SAMPLE_SIZE );
+		for( unsigned char c: sample )
+			hash = ( hash ^ c ) * 1099511628211ull;
+		if( step == 0 )
+			break;
+	}
+	return hash;
+}
+
+//-------------------------------------------------------------------------
+/// Fills the source part of the header, false when the GPX file can't be read.
+bool StampSource( std::string const & iFilePath, CacheHeader & oHeader )
+{
+	std::error_code error;
+	auto const time = std::filesystem::last_write_time( iFilePath, error );
+	if( error )
+		return false;
+	MappedFile const source( iFilePath );
+	if( !source.IsMapped() )
+		return false;
+
+	memcpy( oHeader.magic, CACHE_MAGIC, sizeof( CACHE_MAGIC ) );
+	oHeader.version = CACHE_VERSION;
+	oHeader.byteOrder = CACHE_BYTE_ORDER;
+	oHeader.sourceSize = source.Data().size();
+	oHeader.sourceTime = int64_t( time.time_since_epoch().count() );
+	oHeader.sourceHash = SampledHash( source.Data() );
+	return true;
+}
+
+//-------------------------------------------------------------------------
+size_t PaddedSize( size_t iSize )
+{
+	return ( iSize + 7 ) & ~size_t( 7 );
+}
+
+//-------------------------------------------------------------------------
+template< typename T >
+void ReadColumn( char const * & ioData, size_t iCount, std::vector< T > & oColumn )
+{
+	static_assert( sizeof( T ) == 8, "cache columns are 8 bytes wide" );
+	T const * const values = reinterpret_cast< T const * >( ioData ); // columns are 8 bytes aligned in the mapping
+	oColumn.assign( values, values + iCount );
+	ioData += iCount * sizeof( T );
+}
+
+//-------------------------------------------------------------------------
+template< typename T >
+void WriteColumn( std::ostream & ioStream, std::vector< T > const & iColumn )
+{
+	static_assert( sizeof( T ) == 8, "cache columns are 8 bytes wide" );
+	ioStream.write( reinterpret_cast< char const * >( iColumn.data() ), std::streamsize( iColumn.size() * sizeof( T ) ) );
+}
+
+//-------------------------------------------------------------------------
+/// Times are stored as int64_t whatever the size of time_t is.
+void ReadTimes( char const * & ioData, size_t iCount, std::vector< time_t > & oTimes )
+{
+	if( sizeof( time_t ) == sizeof( int64_t ) ) {
+		time_t const * const values = reinterpret_cast< time_t const * >( ioData );
+		oTimes.assign( values, values + iCount );
+	} else {
+		oTimes.resize( iCount );
+		for( size_t i = 0; i < iCount; ++i ) {
+			int64_t value;
+			memcpy( &value, ioData + i * sizeof( int64_t ), sizeof( int64_t ) );
+			oTimes[ i ] = time_t( value );
+		}
+	}
+	ioData += iCount * sizeof( int64_t );
+}
+
+//-------------------------------------------------------------------------
+void WriteTimes( std::ostream & ioStream, std::vector< time_t > const & iTimes )
+{
+	if( sizeof( time_t ) == sizeof( int64_t ) )
+		ioStream.write( reinterpret_cast< char const * >( iTimes.data() ), std::streamsize( iTimes.size() * sizeof( int64_t ) ) );
+	else
+		WriteColumn( ioStream, std::vector< int64_t >( iTimes.begin(), iTimes.end() ) );
+}
+
+//-------------------------------------------------------------------------
+/// Name of a temporary file next to @a iPath, unique among the processes and threads writing it at once.
+std::string TempPath( std::string const & iPath )
+{
+	static std::atomic< unsigned > counter( 0 );
+#if defined( _WIN32 )
+	long const pid = long( ::_getpid() );
+#else
+	long const pid = long( ::getpid() );
+#endif
+	return iPath + "." + std::to_string( pid ) + "." + std::to_string( counter++ ) + ".tmp";
+}
+
+//#########################################################################
+//---------------------------- Namespace gpx ------------------------------
+//#########################################################################
+std::string gpx::TrackCachePath( std::string const & iFilePath )
+{
+	std::string_view const extension = ".gpx";
+	bool const isGpx = iFilePath.size() >= extension.size() &&
+			std::equal( extension.begin(), extension.end(), iFilePath.end() - extension.size(),
+				[]( char iExpected, char iChar ) { return iExpected == ::tolower( static_cast< unsigned char >( iChar ) ); } );
+	return isGpx ? iFilePath + "c" : iFilePath + ".gpxc";
+}
+
+//-------------------------------------------------------------------------
+bool gpx::ReadTrackCache( std::string const & iFilePath, uint64_t iProcessingKey, Track & oTrack )
+{
+	ProfileScope const scope( "ReadTrackCache" );
+	CacheHeader expected;
+	if( !StampSource( iFilePath, expected ) )
+		return false;
+	MappedFile const cache( TrackCachePath( iFilePath ) );
+	if( !cache.IsMapped() || cache.Data().size() < sizeof( CacheHeader ) )
+		return false;
+
+	std::string_view const data = cache.Data();
+	CacheHeader header;
+	memcpy( &header, data.data(), sizeof( header ) );
+	if( memcmp( header.magic, CACHE_MAGIC, sizeof( CACHE_MAGIC ) ) != 0 || header.version != expected.version ||
+			header.byteOrder != expected.byteOrder || header.sourceSize != expected.sourceSize ||
+			header.sourceTime != expected.sourceTime || header.sourceHash != expected.sourceHash || header.processing != iProcessingKey )
+		return false;
+
+	// check the size before touching columns, a truncated cache must not be read out of bounds
+	size_t const columnSize = size_t( header.count ) * 8;
+	size_t const columnCount = ( header.flags & CACHE_HAS_DISTANCE ) ? 5 : 4;
+	if( header.count > data.size() / 8 || sizeof( CacheHeader ) + columnCount * columnSize > data.size() )
+		return false;
+	char const * column = data.data() + sizeof( CacheHeader );
+	char const * const end = data.data() + data.size();
+
+	Track result;
+	ReadColumn( column, header.count, result.x );
+	ReadColumn( column, header.count, result.y );
+	ReadTimes( column, header.count, result.time );
+	ReadColumn( column, header.count, result.speed );
+	if( header.flags & CACHE_HAS_DISTANCE )
+		ReadColumn( column, header.count, result.distance );
+
+	for( uint64_t i = 0; i < header.extraCount; ++i ) {
+		uint64_t nameSize = 0;
+		if( end - column < 8 )
+			return false;
+		memcpy( &nameSize, column, 8 );
+		column += 8;
+		if( nameSize > size_t( end - column ) || PaddedSize( nameSize ) + columnSize > size_t( end - column ) )
+			return false;
+		std::string name( column, nameSize );
+		column += PaddedSize( nameSize );
+		ReadColumn( column, header.count, result.extraColumns[ name ] );
+	}
+	if( column != end )
+		return false;
+
+	oTrack = std::move( result );
+	return true;
+}
+
+//-------------------------------------------------------------------------
+bool gpx::WriteTrackCache( std::string const & iFilePath, uint64_t iProcessingKey, Track const & iTrack )
+{
+	ProfileScope const scope( "WriteTrackCache" );
+	CacheHeader header;
+	if( !StampSource( iFilePath, header ) )
+		return false;
+	header.count = iTrack.size();
+	header.flags = iTrack.distance.size() == iTrack.size() ? CACHE_HAS_DISTANCE : 0;
+	header.extraCount = iTrack.extraColumns.size();
+	header.processing = iProcessingKey;
+
+	// write a temporary file and replace the cache by it, so a reader never sees a half written cache
+	std::string const cachePath = TrackCachePath( iFilePath );
+	std::string const tempPath = TempPath( cachePath );
+	{
+		std::ofstream file( tempPath, std::ios::binary | std::ios::out | std::ios::trunc );
+		if( !file ) {
+			std::cerr << "gpx: Can't write track cache: " << tempPath << std::endl;
+			return false;
+		}
+		file.write( reinterpret_cast< char const * >( &header ), sizeof( header ) );
+		WriteColumn( file, iTrack.x );
+		WriteColumn( file, iTrack.y );
+		WriteTimes( file, iTrack.time );
+		WriteColumn( file, iTrack.speed );
+		if( header.flags & CACHE_HAS_DISTANCE )
+			WriteColumn( file, iTrack.distance );
+		for( auto const & extra: iTrack.extraColumns ) {
+			uint64_t const nameSize = extra.first.size();
+			char const padding[ 8 ] = {};
+			file.write( reinterpret_cast< char const * >( &nameSize ), sizeof( nameSize ) );
+			file.write( extra.first.data(), std::streamsize( nameSize ) );
+			file.write( padding, std::streamsize( PaddedSize( nameSize ) - nameSize ) );
+			WriteColumn( file, extra.second );
+		}
+		if( !file.flush() ) {
+			std::cerr << "gpx: Can't write track cache: " << tempPath << std::endl;
+			file.close();
+			std::remove( tempPath.c_str() );
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename( tempPath, cachePath, error );
+	if( error ) {
+		std::cerr << "gpx: Can't write track cache: " << cachePath << ", " << error.message() << std::endl;
+		std::filesystem::remove( tempPath, error );
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+#include <stdint.h>
+
+struct Track; // Track.h
+
+namespace gpx
+{
+	/// Path of the binary cache file of a GPX file: "track.gpx" -> "track.gpxc".
+	std::string TrackCachePath( std::string const & iFilePath );
+
+	/// Loads the track of @a iFilePath from its cache, false when the cache is missing, broken, older than the file
+	/// or written with another @a iProcessingKey (a value identifying the options the track is processed with).
+	bool ReadTrackCache( std::string const & iFilePath, uint64_t iProcessingKey, Track & oTrack );
+
+	/// Writes the cache of @a iFilePath next to it, false when it can't be written.
+	bool WriteTrackCache( std::string const & iFilePath, uint64_t iProcessingKey, Track const & iTrack );
+}
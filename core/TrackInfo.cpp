@@ -0,0 +1,141 @@
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include "MGpxTools.h"
+#include "Track.h"
+#include "TrackInfo.h"
+#include "SpeedIndex.h"
+#include "CompressedTrack.h"
+#include "Profiler.h"
+
+bool TrackInfo::calculate( std::vector<Position> const & positions, float speedLimit ) {
+	return calculate( Track::FromPositions( positions ), speedLimit );
+}
+
+bool TrackInfo::calculate( SpeedIndex const & index, float speedLimit ) {
+	return index.Calculate( speedLimit, *this );
+}
+
+bool TrackInfo::calculate( CompressedTrack const & track, float speedLimit ) {
+	return track.CalculateInfo( speedLimit, *this );
+}
+
+bool TrackInfo::calculate( Track const & track, float speedLimit ) {
+	return calculate( track, speedLimit, 0, track.size() > 0 ? track.size() - 1 : 0 );
+}
+
+bool TrackInfo::calculate( Track const & track, float speedLimit, size_t firstSegment, size_t endSegment ) {
+	return calculate< gpx::Equirectangular >( track, speedLimit, firstSegment, endSegment );
+}
+
+template< typename TGeodesic >
+bool TrackInfo::calculate( Track const & track, float speedLimit, size_t firstSegment, size_t endSegment ) {
+	ProfileScope const scope( "TrackInfo::calculate" );
+	endSegment = std::min( endSegment, track.size() > 0 ? track.size() - 1 : 0 );
+	firstSegment = std::min( firstSegment, endSegment );
+	averageSpeed = 0;
+	maxSpeed = std::numeric_limits< float >::min();
+	minSpeed = std::numeric_limits< float >::max();
+	distance = 0;
+	driveDuration = 0;
+	idleCount = 0;
+	idleDuration = 0;
+	overSpeedDuration = 0;
+	overSpeedCount = 0;
+	this->speedLimit = speedLimit;
+	segmentCount = long( endSegment - firstSegment );
+	startsIdle = segmentCount > 0 && track.speed[ firstSegment ] == 0;
+	endsIdle = segmentCount > 0 && track.speed[ endSegment - 1 ] == 0;
+	firstDriveSpeed = 0;
+	lastDriveSpeed = 0;
+
+	// the cache is filled by the formula of gpx::Equirectangular
+	bool const hasDistances = std::is_same< TGeodesic, gpx::Equirectangular >::value && track.distance.size() == track.size();
+	bool idleDetected = false;
+	bool overSpeedDetected = false;
+	for( size_t i = firstSegment; i < endSegment; ++i ) {
+		double const speed = track.speed[ i ];
+		if( speed < 0 )
+			return false;
+
+		int const currentIntervalTime = track.time[ i + 1 ] - track.time[ i ];
+		if( speed > 0 ) {
+			if( firstDriveSpeed == 0 )
+				firstDriveSpeed = speed;
+			lastDriveSpeed = speed;
+			idleDetected = false;
+			distance += hasDistances ? track.distance[ i ] / 1000.0 : TGeodesic::Meters( track.x[ i ], track.y[ i ], track.x[ i + 1 ], track.y[ i + 1 ] ) / 1000.0;
+			maxSpeed = std::max( maxSpeed, speed );
+			minSpeed = std::min( minSpeed, speed );
+			driveDuration += currentIntervalTime;
+			if( speed > speedLimit ) {
+				overSpeedDuration += currentIntervalTime;
+				if( !overSpeedDetected ) {
+					overSpeedDetected = true;
+					overSpeedCount++;
+				}
+			} else
+				overSpeedDetected = false;
+		} else {
+			idleDuration += currentIntervalTime;
+			if( !idleDetected ) {
+				idleDetected = true;
+				idleCount++;
+			}
+		}
+	}
+	averageSpeed = distance / ( driveDuration / 3600.0 );
+	return true;
+}
+
+template bool TrackInfo::calculate< gpx::Equirectangular >( Track const &, float, size_t, size_t );
+template bool TrackInfo::calculate< gpx::Haversine >( Track const &, float, size_t, size_t );
+template bool TrackInfo::calculate< gpx::Vincenty >( Track const &, float, size_t, size_t );
+
+bool TrackInfo::append( TrackInfo const & next ) {
+	return merge( next, true );
+}
+
+bool TrackInfo::add( TrackInfo const & other ) {
+	bool const result = merge( other, false );
+	startsIdle = endsIdle = false;
+	firstDriveSpeed = lastDriveSpeed = 0;
+	return result;
+}
+
+bool TrackInfo::merge( TrackInfo const & other, bool joinRuns ) {
+	if( other.segmentCount == 0 )
+		return true;
+	if( segmentCount == 0 ) {
+		*this = other;
+		return true;
+	}
+	if( speedLimit != other.speedLimit )
+		return false;
+
+	// a stop or an over speed run crossing the border is counted in both parts
+	// (a stop doesn't break an over speed run, the driving speeds around it are compared)
+	if( joinRuns && endsIdle && other.startsIdle )
+		--idleCount;
+	if( joinRuns && lastDriveSpeed > speedLimit && other.firstDriveSpeed > speedLimit )
+		--overSpeedCount;
+
+	// driving speeds of a summary without driving are sentinels of calculate(), min and max skip them
+	maxSpeed = std::max( maxSpeed, other.maxSpeed );
+	minSpeed = std::min( minSpeed, other.minSpeed );
+	distance += other.distance;
+	driveDuration += other.driveDuration;
+	idleCount += other.idleCount;
+	idleDuration += other.idleDuration;
+	overSpeedDuration += other.overSpeedDuration;
+	overSpeedCount += other.overSpeedCount;
+	averageSpeed = distance / ( driveDuration / 3600.0 );
+
+	segmentCount += other.segmentCount;
+	endsIdle = other.endsIdle;
+	if( firstDriveSpeed == 0 )
+		firstDriveSpeed = other.firstDriveSpeed;
+	if( other.lastDriveSpeed > 0 )
+		lastDriveSpeed = other.lastDriveSpeed;
+	return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+struct Position;
+struct Track;
+class SpeedIndex;
+class CompressedTrack;
+
+/**
+ * @struct TrackInfo is a summary of a track or of its part.
+ *
+ * Summaries are mergeable: append() joins summaries of consecutive parts of one track, so a stop or an over speed run
+ * crossing the border of the parts is counted once, add() sums summaries of unrelated tracks. Both are associative,
+ * so daily summaries roll up into weekly and monthly ones without the tracks, see TrackRollup.h.
+ */
+struct TrackInfo
+{
+	bool calculate( Track const & track, float speedLimit );
+	/// Summary of segments [ firstSegment, endSegment ), segment i goes from position i to i + 1.
+	bool calculate( Track const & track, float speedLimit, size_t firstSegment, size_t endSegment );
+	/// Summary with distances by the geodesic policy TGeodesic of Geodesy.h, instantiated for gpx::Equirectangular,
+	/// gpx::Haversine and gpx::Vincenty. The functions above are the ones of gpx::Equirectangular, which takes
+	/// the distance cache of the track when it is filled. Speeds are taken from the track, so they agree with
+	/// the distances for a track read with ReadOptions::geodesic of the same policy.
+	template< typename TGeodesic >
+	bool calculate( Track const & track, float speedLimit, size_t firstSegment = 0, size_t endSegment = SIZE_MAX );
+	bool calculate( std::vector< Position > const & positions, float speedLimit );
+	/// Fast recalculation for a new speed limit, see SpeedIndex.
+	bool calculate( SpeedIndex const & index, float speedLimit );
+	/// Summary of a compressed track, decoded block by block.
+	bool calculate( CompressedTrack const & track, float speedLimit );
+
+	/// Appends the summary of the part of the same track right after this one. false when the speed limits differ.
+	bool append( TrackInfo const & next );
+	/// Adds the summary of an unrelated track, e.g. of another vehicle. false when the speed limits differ.
+	/// Nothing is joined to the result by a later append().
+	bool add( TrackInfo const & other );
+
+	double averageSpeed = 0;
+	double maxSpeed = 0;
+	double minSpeed = 0;
+	double distance = 0;
+	long driveDuration = 0;
+	int idleCount = 0;
+	long idleDuration = 0;
+	long overSpeedDuration = 0;
+	int overSpeedCount = 0;
+
+	// state at the borders for append()
+	float speedLimit = 0;
+	long segmentCount = 0;       /// 0 - the summary is empty
+	bool startsIdle = false;     /// the first segment is a stop
+	bool endsIdle = false;       /// the last segment is a stop
+	double firstDriveSpeed = 0;  /// speed of the first driving segment, 0 when there is none
+	double lastDriveSpeed = 0;   /// speed of the last driving segment, 0 when there is none
+
+private:
+	bool merge( TrackInfo const & other, bool joinRuns );
+};
@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <charconv>
+#include <numeric>
+#include <algorithm>
+#include "TrackRollup.h"
+#include "Track.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include "IsoTimeDecoder.h"
+
+int64_t const SECONDS_PER_DAY = 86400;
+char const * const SUMMARIES_HEADER = "#vehicle\tday\tspeed_limit\tsegments\tdistance_km\tdrive_duration\tidle_count\tidle_duration\t"
+	"over_speed_count\tover_speed_duration\tmax_speed\tmin_speed\tstarts_idle\tends_idle\tfirst_drive_speed\tlast_drive_speed";
+size_t const SUMMARY_FIELD_COUNT = 16;
+
+//-------------------------------------------------------------------------
+/// Date of days from 1970-01-01, the inverse of IsoTimeDecoder::DaysFromCivil.
+void CivilFromDays( int64_t iDays, int64_t & oYear, unsigned & oMonth, unsigned & oDay )
+{
+	int64_t const days = iDays + 719468;
+	int64_t const era = ( days >= 0 ? days : days - 146096 ) / 146097;
+	int64_t const dayOfEra = days - era * 146097;
+	int64_t const yearOfEra = ( dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096 ) / 365;
+	int64_t const dayOfYear = dayOfEra - ( 365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100 );
+	int64_t const monthFromMarch = ( 5 * dayOfYear + 2 ) / 153;
+	oDay = unsigned( dayOfYear - ( 153 * monthFromMarch + 2 ) / 5 + 1 );
+	oMonth = unsigned( monthFromMarch < 10 ? monthFromMarch + 3 : monthFromMarch - 9 );
+	oYear = yearOfEra + era * 400 + ( oMonth <= 2 );
+}
+
+//-------------------------------------------------------------------------
+int64_t FloorDiv( int64_t iValue, int64_t iDivisor )
+{
+	return iValue / iDivisor - ( iValue % iDivisor < 0 );
+}
+
+//-------------------------------------------------------------------------
+/// Splits @a iLine by tabs.
+std::vector< std::string > SplitFields( std::string const & iLine )
+{
+	std::vector< std::string > result;
+	size_t start = 0;
+	for( size_t tab = iLine.find( '\t' ); tab != std::string::npos; tab = iLine.find( '\t', start ) ) {
+		result.push_back( iLine.substr( start, tab - start ) );
+		start = tab + 1;
+	}
+	result.push_back( iLine.substr( start ) );
+	return result;
+}
+
+//-------------------------------------------------------------------------
+/// Locale independent parsing of a whole field.
+template< typename T >
+bool ParseNumber( std::string const & iText, T & oValue )
+{
+	std::from_chars_result const result = std::from_chars( iText.data(), iText.data() + iText.size(), oValue );
+	return result.ec == std::errc() && result.ptr == iText.data() + iText.size();
+}
+
+//-------------------------------------------------------------------------
+/// Appends a tab and the shortest text of @a iValue which is read back exactly, locale independent.
+template< typename T >
+void AppendField( std::string & ioLine, T iValue )
+{
+	char buffer[ 32 ];
+	std::to_chars_result const result = std::to_chars( buffer, buffer + sizeof( buffer ), iValue );
+	ioLine += '\t';
+	ioLine.append( buffer, result.ptr );
+}
+
+//-------------------------------------------------------------------------
+/// Parses one line of WriteSummaries.
+bool ParseSummary( std::string const & iLine, gpx::DaySummary & oSummary )
+{
+	std::vector< std::string > const fields = SplitFields( iLine );
+	if( fields.size() != SUMMARY_FIELD_COUNT )
+		return false;
+	TrackInfo & info = oSummary.info;
+	int startsIdle = 0, endsIdle = 0;
+	oSummary.vehicle = fields[ 0 ];
+	bool const parsed = gpx::ParseDay( fields[ 1 ], oSummary.day ) && ParseNumber( fields[ 2 ], info.speedLimit ) &&
+		ParseNumber( fields[ 3 ], info.segmentCount ) && ParseNumber( fields[ 4 ], info.distance ) &&
+		ParseNumber( fields[ 5 ], info.driveDuration ) && ParseNumber( fields[ 6 ], info.idleCount ) &&
+		ParseNumber( fields[ 7 ], info.idleDuration ) && ParseNumber( fields[ 8 ], info.overSpeedCount ) &&
+		ParseNumber( fields[ 9 ], info.overSpeedDuration ) && ParseNumber( fields[ 10 ], info.maxSpeed ) &&
+		ParseNumber( fields[ 11 ], info.minSpeed ) && ParseNumber( fields[ 12 ], startsIdle ) &&
+		ParseNumber( fields[ 13 ], endsIdle ) && ParseNumber( fields[ 14 ], info.firstDriveSpeed ) &&
+		ParseNumber( fields[ 15 ], info.lastDriveSpeed );
+	info.startsIdle = startsIdle != 0;
+	info.endsIdle = endsIdle != 0;
+	info.averageSpeed = info.distance / ( info.driveDuration / 3600.0 );
+	return parsed;
+}
+
+// --------------------------------------------------------------------------------------
+/// Totals of one vehicle, made by a task of Rollup.
+struct VehicleRollup
+{
+	bool                                      valid = true;
+	TrackInfo                                 total;
+	std::vector< std::pair< int64_t, TrackInfo > > periods; /// ascending
+};
+
+//-------------------------------------------------------------------------
+/// Appends summaries @a iOrder[ iFirst, iEnd ) of one vehicle sorted by day.
+void RollupVehicle( std::vector< gpx::DaySummary > const & iSummaries, std::vector< size_t > const & iOrder,
+	size_t iFirst, size_t iEnd, gpx::EPeriod iPeriod, VehicleRollup & oRollup )
+{
+	for( size_t i = iFirst; i < iEnd; ++i ) {
+		gpx::DaySummary const & summary = iSummaries[ iOrder[ i ] ];
+		int64_t const period = gpx::PeriodStart( summary.day, iPeriod );
+		if( oRollup.periods.empty() || oRollup.periods.back().first != period )
+			oRollup.periods.emplace_back( period, TrackInfo() );
+		oRollup.valid = oRollup.periods.back().second.append( summary.info ) && oRollup.total.append( summary.info ) && oRollup.valid;
+	}
+}
+
+//#########################################################################
+//---------------------------- Namespace gpx ------------------------------
+//#########################################################################
+int64_t gpx::DayOf( time_t iTime )
+{
+	return FloorDiv( int64_t( iTime ), SECONDS_PER_DAY );
+}
+
+//-------------------------------------------------------------------------
+int64_t gpx::PeriodStart( int64_t iDay, EPeriod iPeriod )
+{
+	switch( iPeriod ) {
+	case EPeriod::Week:
+		return iDay - ( iDay + 3 - FloorDiv( iDay + 3, 7 ) * 7 ); // 1970-01-01 is Thursday
+	case EPeriod::Month: {
+		int64_t year;
+		unsigned month, day;
+		CivilFromDays( iDay, year, month, day );
+		return IsoTimeDecoder::DaysFromCivil( int( year ), int( month ), 1 );
+	}
+	case EPeriod::Day:
+		break;
+	}
+	return iDay;
+}
+
+//-------------------------------------------------------------------------
+std::string gpx::FormatDay( int64_t iDay )
+{
+	int64_t year;
+	unsigned month, day;
+	CivilFromDays( iDay, year, month, day );
+	char buffer[ 32 ];
+	snprintf( buffer, sizeof( buffer ), "%04lld-%02u-%02u", (long long)year, month, day );
+	return buffer;
+}
+
+//-------------------------------------------------------------------------
+bool gpx::ParseDay( std::string const & iText, int64_t & oDay )
+{
+	int year = 0;
+	unsigned month = 0, day = 0;
+	int consumed = 0;
+	if( sscanf( iText.c_str(), "%d-%u-%u%n", &year, &month, &day, &consumed ) != 3 || size_t( consumed ) != iText.size() ||
+			month < 1 || month > 12 || day < 1 || day > 31 )
+		return false;
+	oDay = IsoTimeDecoder::DaysFromCivil( year, int( month ), int( day ) );
+	return true;
+}
+
+//-------------------------------------------------------------------------
+template< typename TGeodesic >
+bool gpx::SummarizeDays( std::string const & iVehicle, Track const & iTrack, float iSpeedLimit, std::vector< DaySummary > & oSummaries )
+{
+	for( size_t first = 0; first + 1 < iTrack.size(); ) {
+		int64_t const day = DayOf( iTrack.time[ first ] );
+		time_t const nextDayStart = time_t( ( day + 1 ) * SECONDS_PER_DAY );
+		size_t const end = std::min( size_t( std::lower_bound( iTrack.time.begin() + first, iTrack.time.end(), nextDayStart ) - iTrack.time.begin() ),
+			iTrack.size() - 1 );
+		DaySummary summary;
+		summary.vehicle = iVehicle;
+		summary.day = day;
+		if( !summary.info.calculate< TGeodesic >( iTrack, iSpeedLimit, first, end ) )
+			return false;
+		oSummaries.push_back( std::move( summary ) );
+		first = end;
+	}
+	return true;
+}
+
+template bool gpx::SummarizeDays< gpx::Equirectangular >( std::string const &, Track const &, float, std::vector< DaySummary > & );
+template bool gpx::SummarizeDays< gpx::Haversine >( std::string const &, Track const &, float, std::vector< DaySummary > & );
+template bool gpx::SummarizeDays< gpx::Vincenty >( std::string const &, Track const &, float, std::vector< DaySummary > & );
+
+//-------------------------------------------------------------------------
+bool gpx::Rollup( std::vector< DaySummary > const & iSummaries, EPeriod iPeriod, ThreadPool & ioPool, RollupResult & oResult )
+{
+	ProfileScope const scope( "Rollup" );
+	std::vector< size_t > order( iSummaries.size() );
+	std::iota( order.begin(), order.end(), 0 );
+	std::stable_sort( order.begin(), order.end(), [&iSummaries]( size_t iLeft, size_t iRight ) {
+		DaySummary const & left = iSummaries[ iLeft ];
+		DaySummary const & right = iSummaries[ iRight ];
+		return left.vehicle != right.vehicle ? left.vehicle < right.vehicle : left.day < right.day;
+	} );
+
+	// every vehicle is a task, days of a vehicle must be appended in order
+	std::vector< std::pair< size_t, size_t > > vehicleRanges;
+	for( size_t first = 0, end = 0; first < order.size(); first = end ) {
+		for( end = first + 1; end < order.size() && iSummaries[ order[ end ] ].vehicle == iSummaries[ order[ first ] ].vehicle; ++end )
+			;
+		vehicleRanges.emplace_back( first, end );
+	}
+	std::vector< VehicleRollup > vehicles( vehicleRanges.size() );
+	ioPool.ForEach( vehicleRanges.size(), [&]( size_t i ) {
+		RollupVehicle( iSummaries, order, vehicleRanges[ i ].first, vehicleRanges[ i ].second, iPeriod, vehicles[ i ] );
+	} );
+
+	// vehicles are added up, that is a short sequential pass over totals
+	RollupResult result;
+	bool valid = true;
+	for( size_t i = 0; i < vehicles.size(); ++i ) {
+		std::string const & name = iSummaries[ order[ vehicleRanges[ i ].first ] ].vehicle;
+		valid = vehicles[ i ].valid && result.fleet.add( vehicles[ i ].total ) && valid;
+		result.vehicles[ name ] = vehicles[ i ].total;
+		for( auto const & period: vehicles[ i ].periods ) {
+			result.vehiclePeriods[ { name, period.first } ] = period.second;
+			valid = result.periods[ period.first ].add( period.second ) && valid;
+		}
+	}
+	oResult = std::move( result );
+	return valid;
+}
+
+//-------------------------------------------------------------------------
+void gpx::WriteSummaries( std::ostream & ioStream, std::vector< DaySummary > const & iSummaries )
+{
+	ioStream << SUMMARIES_HEADER << "\n";
+	std::string line;
+	for( DaySummary const & summary: iSummaries ) {
+		line = summary.vehicle;
+		std::replace_if( line.begin(), line.end(), []( char c ) { return c == '\t' || c == '\n' || c == '\r'; }, ' ' );
+		line += '\t';
+		line += FormatDay( summary.day );
+		TrackInfo const & info = summary.info;
+		AppendField( line, info.speedLimit );
+		AppendField( line, info.segmentCount );
+		AppendField( line, info.distance );
+		AppendField( line, info.driveDuration );
+		AppendField( line, info.idleCount );
+		AppendField( line, info.idleDuration );
+		AppendField( line, info.overSpeedCount );
+		AppendField( line, info.overSpeedDuration );
+		AppendField( line, info.maxSpeed );
+		AppendField( line, info.minSpeed );
+		AppendField( line, int( info.startsIdle ) );
+		AppendField( line, int( info.endsIdle ) );
+		AppendField( line, info.firstDriveSpeed );
+		AppendField( line, info.lastDriveSpeed );
+		ioStream << line << "\n";
+	}
+}
+
+//-------------------------------------------------------------------------
+bool gpx::ReadSummaries( std::istream & ioStream, std::vector< DaySummary > & oSummaries )
+{
+	std::string line;
+	while( std::getline( ioStream, line ) ) {
+		if( !line.empty() && line.back() == '\r' )
+			line.pop_back();
+		if( line.empty() || line == SUMMARIES_HEADER ) // a vehicle name may start with '#' as well
+			continue;
+		DaySummary summary;
+		if( !ParseSummary( line, summary ) )
+			return false;
+		oSummaries.push_back( std::move( summary ) );
+	}
+	return true;
+}
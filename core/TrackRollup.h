@@ -0,0 +1,66 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <istream>
+#include <ostream>
+#include <utility>
+#include <stdint.h>
+#include <time.h>
+#include "TrackInfo.h"
+#include "Geodesy.h"
+
+struct Track;
+class ThreadPool;
+
+/**
+ * Fleet reports built of daily TrackInfo summaries.
+ *
+ * A track is summarized per UTC day once, the summaries are persisted and rolled up into days, weeks or months
+ * for every vehicle and for the whole fleet without reading the tracks again.
+ */
+namespace gpx
+{
+	/// Summary of one vehicle for one day, days are counted from 1970-01-01 UTC.
+	struct DaySummary
+	{
+		std::string vehicle;
+		int64_t     day = 0;
+		TrackInfo   info;
+	};
+
+	enum class EPeriod { Day, Week, Month };
+
+	/// Day of a time, UTC.
+	int64_t DayOf( time_t iTime );
+	/// The first day of the period containing @a iDay, weeks start on Monday.
+	int64_t PeriodStart( int64_t iDay, EPeriod iPeriod );
+	/// "YYYY-MM-DD" of a day and back, ParseDay returns false for another format.
+	std::string FormatDay( int64_t iDay );
+	bool ParseDay( std::string const & iText, int64_t & oDay );
+
+	/// Appends summaries of every day of the track to @a oSummaries, a segment belongs to the day it starts in.
+	/// false when the track has negative speed. Distances are the ones of TrackInfo::calculate< TGeodesic >.
+	template< typename TGeodesic = Equirectangular >
+	bool SummarizeDays( std::string const & iVehicle, Track const & iTrack, float iSpeedLimit, std::vector< DaySummary > & oSummaries );
+
+	/// Totals of summaries, maps are keyed by the first day of a period.
+	struct RollupResult
+	{
+		std::map< std::pair< std::string, int64_t >, TrackInfo > vehiclePeriods;
+		std::map< std::string, TrackInfo >                        vehicles;
+		std::map< int64_t, TrackInfo >                            periods;  /// all vehicles
+		TrackInfo                                                 fleet;
+	};
+
+	/// Rolls up summaries: days of a vehicle are appended in order, vehicles are added up.
+	/// Vehicles are reduced in parallel on @a ioPool. false when the summaries have different speed limits.
+	bool Rollup( std::vector< DaySummary > const & iSummaries, EPeriod iPeriod, ThreadPool & ioPool, RollupResult & oResult );
+
+	/// Summaries as tab separated text with a header line, doubles are written exactly.
+	void WriteSummaries( std::ostream & ioStream, std::vector< DaySummary > const & iSummaries );
+	/// Appends summaries written by WriteSummaries, false on a malformed line. Header lines and empty lines are skipped,
+	/// so outputs of several WriteSummaries may be concatenated.
+	bool ReadSummaries( std::istream & ioStream, std::vector< DaySummary > & oSummaries );
+}
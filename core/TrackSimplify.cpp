@@ -0,0 +1,206 @@
+#include <math.h>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+#include "TrackSimplify.h"
+#include "Track.h"
+#include "Geodesy.h"
+#include "SegmentKernels.h"
+#include "Profiler.h"
+
+size_t const SIMPLIFY_WINDOW = 1024; // every that many positions is kept, it limits the quadratic worst case of Douglas-Peucker
+
+//-------------------------------------------------------------------------
+/// Sum of TrackInfo::calculate< TGeodesic > distance of moving segments, km.
+template< typename TGeodesic >
+double MovingDistance( Track const & iTrack )
+{
+	bool const equirectangular = std::is_same< TGeodesic, gpx::Equirectangular >::value;
+	std::vector< double > meters = iTrack.distance;
+	if( !equirectangular || meters.size() != iTrack.size() ) {
+		meters.assign( iTrack.size(), 0 );
+		if( equirectangular && iTrack.size() > 1 )
+			gpx::SegmentDistances( iTrack.x.data(), iTrack.y.data(), iTrack.size(), meters.data() );
+		else
+			for( size_t i = 0; i + 1 < iTrack.size(); ++i )
+				meters[ i ] = TGeodesic::Meters( iTrack.x[ i ], iTrack.y[ i ], iTrack.x[ i + 1 ], iTrack.y[ i + 1 ] );
+	}
+	double result = 0;
+	for( size_t i = 0; i + 1 < iTrack.size(); ++i )
+		if( iTrack.speed[ i ] > 0 )
+			result += meters[ i ] / 1000.0;
+	return result;
+}
+
+// --------------------------------------------------------------------------------------
+/**
+ * @class Simplifier marks positions kept by Douglas-Peucker between two kept anchors.
+ *
+ * All segments between the anchors are either moving or idle. A range is replaced by one segment
+ * when every position in it is close to the place where that segment is at the position time, and for
+ * moving ranges every segment speed is close to the speed of the replacing segment, by the distance of TGeodesic.
+ */
+template< typename TGeodesic >
+class Simplifier
+{
+public:
+	Simplifier( Track const & iTrack, gpx::SimplifyOptions const & iOptions, std::vector< char > & ioKeep )
+		: m_track( iTrack )
+		, m_options( iOptions )
+		, m_keep( ioKeep )
+	{}
+
+	void Simplify( size_t iFirst, size_t iLast );
+
+	double MaxDeviation() const { return m_maxDeviation; }
+	double MaxSpeedError() const { return m_maxSpeedError; }
+
+private:
+	Track const &                           m_track;
+	gpx::SimplifyOptions const &            m_options;
+	std::vector< char > &                   m_keep;
+	std::vector< std::pair< size_t, size_t > > m_ranges; /// ranges to check, reused between calls
+	double                                  m_maxDeviation = 0;
+	double                                  m_maxSpeedError = 0;
+};
+
+//-------------------------------------------------------------------------
+template< typename TGeodesic >
+void Simplifier< TGeodesic >::Simplify( size_t iFirst, size_t iLast )
+{
+	Track const & t = m_track;
+	bool const moving = t.speed[ iFirst ] > 0;
+	m_ranges.assign( 1, { iFirst, iLast } );
+	while( !m_ranges.empty() ) {
+		auto const [ a, b ] = m_ranges.back();
+		m_ranges.pop_back();
+		if( b - a < 2 )
+			continue;
+
+		// the synchronized distance in Y-degrees with one cosine for the whole range, the ranges are short
+		double const duration = double( t.time[ b ] - t.time[ a ] );
+		double const cosY = CosLatitude( ( t.y[ a ] + t.y[ b ] ) / 2 );
+		double maxDeviation = 0;
+		size_t split = a;
+		for( size_t i = a + 1; i < b; ++i ) {
+			double const part = duration > 0 ? ( t.time[ i ] - t.time[ a ] ) / duration : 0;
+			double const dx = ( t.x[ a ] + ( t.x[ b ] - t.x[ a ] ) * part - t.x[ i ] ) * cosY;
+			double const dy = t.y[ a ] + ( t.y[ b ] - t.y[ a ] ) * part - t.y[ i ];
+			double const deviation = dx * dx + dy * dy;
+			if( deviation > maxDeviation ) {
+				maxDeviation = deviation;
+				split = i;
+			}
+		}
+		maxDeviation = YDegreesToMeters( ::sqrt( maxDeviation ) );
+
+		double maxSpeedError = 0;
+		if( moving && maxDeviation <= m_options.toleranceMeters ) {
+			double const speed = gpx::SegmentSpeed( TGeodesic::Meters( t.x[ a ], t.y[ a ], t.x[ b ], t.y[ b ] ), t.time[ a ], t.time[ b ] );
+			if( speed <= 0 ) { // a round trip, the segment would become idle
+				maxSpeedError = HUGE_VAL;
+				split = ( a + b ) / 2;
+			}
+			for( size_t i = a; i < b && speed > 0; ++i ) {
+				double const error = ::fabs( t.speed[ i ] - speed );
+				if( error > maxSpeedError ) {
+					maxSpeedError = error;
+					if( error > m_options.speedToleranceKmh )
+						split = i > a ? i : i + 1;
+				}
+			}
+			// the segments of the range are on one side of every limit, the replacing one must be there too
+			for( float limit: m_options.speedLimits ) {
+				if( ( speed > limit ) == ( t.speed[ a ] > limit ) )
+					continue;
+				maxSpeedError = HUGE_VAL;
+				if( split == a )
+					split = ( a + b ) / 2;
+				break;
+			}
+		}
+
+		if( maxDeviation > m_options.toleranceMeters || maxSpeedError > m_options.speedToleranceKmh ) {
+			m_keep[ split ] = 1;
+			m_ranges.push_back( { a, split } );
+			m_ranges.push_back( { split, b } );
+		} else {
+			m_maxDeviation = std::max( m_maxDeviation, maxDeviation );
+			m_maxSpeedError = std::max( m_maxSpeedError, maxSpeedError );
+		}
+	}
+}
+
+//#########################################################################
+//---------------------------- Namespace gpx ------------------------------
+//#########################################################################
+template< typename TGeodesic >
+Track gpx::SimplifyTrack( Track const & iTrack, SimplifyOptions const & iOptions, SimplifyReport * oReport )
+{
+	ProfileScope const scope( "Simplify" );
+	size_t const n = iTrack.size();
+	if( !iOptions.IsEnabled() || n < 3 ) {
+		if( oReport )
+			*oReport = SimplifyReport{ n, n };
+		return iTrack;
+	}
+
+	// anchors: the ends, borders of idle intervals and of over speed runs, window borders
+	std::vector< char > keep( n, 0 );
+	keep.front() = keep.back() = 1;
+	for( size_t i = 1; i + 1 < n; ++i ) {
+		double const previous = iTrack.speed[ i - 1 ], speed = iTrack.speed[ i ];
+		keep[ i ] = ( previous > 0 ) != ( speed > 0 ) || i % SIMPLIFY_WINDOW == 0 ||
+				std::any_of( iOptions.speedLimits.begin(), iOptions.speedLimits.end(), [=]( float iLimit ) { return ( previous > iLimit ) != ( speed > iLimit ); } );
+	}
+
+	Simplifier< TGeodesic > simplifier( iTrack, iOptions, keep );
+	for( size_t first = 0, last = 1; last < n; ++last ) {
+		if( !keep[ last ] )
+			continue;
+		simplifier.Simplify( first, last );
+		first = last;
+	}
+
+	std::vector< size_t > kept;
+	for( size_t i = 0; i < n; ++i )
+		if( keep[ i ] )
+			kept.push_back( i );
+
+	Track result;
+	result.reserve( kept.size() );
+	for( size_t i: kept ) {
+		result.x.push_back( iTrack.x[ i ] );
+		result.y.push_back( iTrack.y[ i ] );
+		result.time.push_back( iTrack.time[ i ] );
+	}
+	for( auto const & [ name, column ]: iTrack.extraColumns ) {
+		std::vector< double > & keptColumn = result.extraColumns[ name ];
+		keptColumn.reserve( kept.size() );
+		for( size_t i: kept )
+			keptColumn.push_back( column[ i ] );
+	}
+
+	// moving segments get the speed by the distance, idle ones stay idle
+	result.speed.resize( kept.size() );
+	for( size_t i = 0; i + 1 < kept.size(); ++i )
+		result.speed[ i ] = iTrack.speed[ kept[ i ] ] > 0 ? -1 : 0;
+	if( std::is_same< TGeodesic, Equirectangular >::value )
+		result.distance.assign( kept.size(), 0 );
+	gpx::FillSegmentSpeeds< TGeodesic >( result, 0, kept.size() - 1 );
+	result.speed.back() = result.speed[ kept.size() - 2 ];
+
+	Profiler::Add( Profiler::PositionsSimplified, n - kept.size() );
+	if( oReport ) {
+		oReport->inputCount = n;
+		oReport->outputCount = kept.size();
+		oReport->maxDeviationMeters = simplifier.MaxDeviation();
+		oReport->maxSpeedErrorKmh = simplifier.MaxSpeedError();
+		oReport->distanceLossKm = MovingDistance< TGeodesic >( iTrack ) - MovingDistance< TGeodesic >( result );
+	}
+	return result;
+}
+
+template Track gpx::SimplifyTrack< gpx::Equirectangular >( Track const &, SimplifyOptions const &, SimplifyReport * );
+template Track gpx::SimplifyTrack< gpx::Haversine >( Track const &, SimplifyOptions const &, SimplifyReport * );
+template Track gpx::SimplifyTrack< gpx::Vincenty >( Track const &, SimplifyOptions const &, SimplifyReport * );
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>
+#include <vector>
+#include "Geodesy.h"
+
+struct Track; // Track.h
+
+namespace gpx
+{
+	/// Tolerances of a track simplification.
+	struct SimplifyOptions
+	{
+		/// Max distance in meters between a removed position and the place where the simplified track is at its time,
+		/// 0 - no simplification.
+		double toleranceMeters = 0;
+		/// Max difference in km/h between the speed of a removed segment and the speed of the segment replacing it.
+		double speedToleranceKmh = 5;
+		/// Speed limits in km/h the track is analyzed with: every segment of the result stays over or under each of them
+		/// like the segments it replaces, so TrackInfo over speed count and duration for these limits are exact.
+		std::vector< float > speedLimits;
+
+		bool IsEnabled() const { return toleranceMeters > 0; }
+	};
+
+	/// What a simplification has changed, TrackInfo of the result differs from the original one within these bounds.
+	struct SimplifyReport
+	{
+		size_t inputCount = 0;
+		size_t outputCount = 0;
+		double maxDeviationMeters = 0; /// max distance of a removed position from the simplified track at its time
+		double maxSpeedErrorKmh = 0;   /// max speed difference of a removed segment, bounds the error of max and min speed
+		double distanceLossKm = 0;     /// TrackInfo::distance of the original track minus the one of the result
+	};
+
+	/**
+	 * Removes positions which can be interpolated by time from their neighbours within @a iOptions.
+	 *
+	 * Douglas-Peucker by the synchronized euclidean distance runs in windows of a fixed size,
+	 * so the worst case is linear. Borders of idle intervals (zero speed, gaps included) are always kept,
+	 * so idle count, idle and drive durations of TrackInfo stay exact. So are positions where the speed crosses
+	 * a limit of SimplifyOptions::speedLimits, and a replacing segment never crosses one, so over speed count and
+	 * duration stay exact for them. For other limits they may change, only for segments with a speed within
+	 * SimplifyReport::maxSpeedErrorKmh of the limit.
+	 * Speeds and distances are the ones of the geodesic policy TGeodesic of Geodesy.h, instantiated for the policies there.
+	 */
+	template< typename TGeodesic = Equirectangular >
+	Track SimplifyTrack( Track const & iTrack, SimplifyOptions const & iOptions, SimplifyReport * oReport = nullptr );
+}
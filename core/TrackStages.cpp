@@ -0,0 +1,156 @@
+#include <numeric>
+#include <type_traits>
+#include <algorithm>
+#include "TrackStages.h"
+#include "Track.h"
+#include "SegmentKernels.h"
+#include "Profiler.h"
+
+//-------------------------------------------------------------------------
+/// Calls @a iFunction for every column of the track but the distance cache, the stages clear it.
+template< typename TFunction >
+void ForEachColumn( Track & ioTrack, TFunction const & iFunction )
+{
+	iFunction( ioTrack.x );
+	iFunction( ioTrack.y );
+	iFunction( ioTrack.time );
+	iFunction( ioTrack.speed );
+	for( auto & extra: ioTrack.extraColumns )
+		iFunction( extra.second );
+}
+
+//-------------------------------------------------------------------------
+void Filter( Track & ioTrack, std::function< bool( Position const & ) > const & iKeep )
+{
+	std::vector< char > keep( ioTrack.size() );
+	for( size_t i = 0; i < ioTrack.size(); ++i )
+		keep[ i ] = iKeep( ioTrack.position( i ) );
+	if( std::find( keep.begin(), keep.end(), 0 ) == keep.end() )
+		return;
+
+	ForEachColumn( ioTrack, [&keep]( auto & ioColumn ) {
+		size_t kept = 0;
+		for( size_t i = 0; i < ioColumn.size(); ++i )
+			if( keep[ i ] )
+				ioColumn[ kept++ ] = ioColumn[ i ];
+		ioColumn.resize( kept );
+	} );
+	ioTrack.distance.clear();
+}
+
+//-------------------------------------------------------------------------
+void Order( Track & ioTrack )
+{
+	if( std::is_sorted( ioTrack.time.begin(), ioTrack.time.end() ) )
+		return; // the parser drops non-chronological positions, so it is the usual case
+
+	std::vector< size_t > order( ioTrack.size() );
+	std::iota( order.begin(), order.end(), 0 );
+	std::stable_sort( order.begin(), order.end(), [&ioTrack]( size_t iLeft, size_t iRight ) { return ioTrack.time[ iLeft ] < ioTrack.time[ iRight ]; } );
+	ForEachColumn( ioTrack, [&order]( auto & ioColumn ) {
+		typename std::decay< decltype( ioColumn ) >::type sorted( ioColumn.size() );
+		for( size_t i = 0; i < order.size(); ++i )
+			sorted[ i ] = ioColumn[ order[ i ] ];
+		ioColumn.swap( sorted );
+	} );
+	ioTrack.distance.clear();
+}
+
+//-------------------------------------------------------------------------
+void FillGaps( Track & ioTrack, time_t iGapTime )
+{
+	// positions starting a pause, the copy of each one is inserted before it
+	std::vector< size_t > gapEnds;
+	for( size_t i = 1; i < ioTrack.size(); ++i )
+		if( ioTrack.time[ i ] - ioTrack.time[ i - 1 ] > iGapTime )
+			gapEnds.push_back( i );
+	Profiler::Add( Profiler::GapsFilled, gapEnds.size() );
+	if( gapEnds.empty() )
+		return;
+
+	// spread every column from the back, so each value moves once and nothing is overwritten before it is moved
+	ForEachColumn( ioTrack, [&gapEnds]( auto & ioColumn ) {
+		size_t const count = ioColumn.size();
+		ioColumn.resize( count + gapEnds.size() );
+		size_t to = ioColumn.size();
+		size_t gap = gapEnds.size();
+		for( size_t i = count; i-- > 0; ) {
+			ioColumn[ --to ] = ioColumn[ i ];
+			if( gap > 0 && gapEnds[ gap - 1 ] == i ) {
+				ioColumn[ --to ] = ioColumn[ i ];
+				--gap;
+			}
+		}
+	} );
+	for( size_t gap = 0; gap < gapEnds.size(); ++gap ) {
+		size_t const inserted = gapEnds[ gap ] + gap;
+		ioTrack.time[ inserted ] -= 1;
+		ioTrack.speed[ inserted ] = 0;
+		ioTrack.speed[ inserted - 1 ] = 0;
+	}
+	ioTrack.distance.clear();
+}
+
+//-------------------------------------------------------------------------
+template< typename TGeodesic >
+void CalculateSpeeds( Track & ioTrack )
+{
+	if( ioTrack.size() < 2 )
+		return;
+	if( std::is_same< TGeodesic, gpx::Equirectangular >::value )
+		ioTrack.distance.assign( ioTrack.size(), 0 );
+	gpx::FillSegmentSpeeds< TGeodesic >( ioTrack, 0, ioTrack.size() - 1 );
+	if( ioTrack.speed.back() < 0 )
+		ioTrack.speed.back() = ioTrack.speed[ ioTrack.size() - 2 ];
+}
+
+//#########################################################################
+//---------------------------- Namespace gpx ------------------------------
+//#########################################################################
+gpx::TrackStage gpx::FilterStage( std::function< bool( Position const & iPos ) > iKeep )
+{
+	return { "Filter", [iKeep]( Track & ioTrack ) { Filter( ioTrack, iKeep ); } };
+}
+
+//-------------------------------------------------------------------------
+gpx::TrackStage gpx::OrderStage()
+{
+	return { "Sort", Order };
+}
+
+//-------------------------------------------------------------------------
+gpx::TrackStage gpx::GapStage( time_t iGapTime )
+{
+	return { "Fill gaps", [iGapTime]( Track & ioTrack ) { FillGaps( ioTrack, iGapTime ); } };
+}
+
+//-------------------------------------------------------------------------
+template< typename TGeodesic >
+gpx::TrackStage gpx::SpeedStage()
+{
+	return { "Distances and speeds", CalculateSpeeds< TGeodesic > };
+}
+
+template gpx::TrackStage gpx::SpeedStage< gpx::Equirectangular >();
+template gpx::TrackStage gpx::SpeedStage< gpx::Haversine >();
+template gpx::TrackStage gpx::SpeedStage< gpx::Vincenty >();
+
+//-------------------------------------------------------------------------
+template< typename TGeodesic >
+gpx::TTrackStages gpx::DefaultStages( time_t iGapTime )
+{
+	return { OrderStage(), GapStage( iGapTime ), SpeedStage< TGeodesic >() };
+}
+
+template gpx::TTrackStages gpx::DefaultStages< gpx::Equirectangular >( time_t );
+template gpx::TTrackStages gpx::DefaultStages< gpx::Haversine >( time_t );
+template gpx::TTrackStages gpx::DefaultStages< gpx::Vincenty >( time_t );
+
+//-------------------------------------------------------------------------
+void gpx::RunStages( TTrackStages const & iStages, Track & ioTrack )
+{
+	for( TrackStage const & stage: iStages ) {
+		ProfileScope const scope( stage.name );
+		stage.run( ioTrack );
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <time.h>
+#include <vector>
+#include <functional>
+#include "Geodesy.h"
+
+struct Position; // MGpxTools.h
+struct Track;    // Track.h
+
+/**
+ * Processing of parsed positions as a chain of stages.
+ *
+ * Every stage changes the track in place with a linear pass over its columns, so stages compose
+ * without copies of the whole track. ReadTrack runs DefaultStages unless ReadOptions::stages is given,
+ * a custom chain is usually DefaultStages with own stages inserted.
+ */
+namespace gpx
+{
+	time_t const DEFAULT_GAP_TIME = 60;
+
+	/// A step of the processing of a track.
+	struct TrackStage
+	{
+		char const *                             name; /// profiler span of the stage
+		std::function< void( Track & ioTrack ) > run;
+	};
+	typedef std::vector< TrackStage > TTrackStages;
+
+	/// Drops positions @a iKeep returns false for.
+	TrackStage FilterStage( std::function< bool( Position const & iPos ) > iKeep );
+	/// Sorts positions by time, a sorted track is only checked.
+	TrackStage OrderStage();
+	/// Closes pauses longer than @a iGapTime seconds with zero speed: the position before a pause gets zero speed
+	/// and a copy of the position after it is inserted 1 second earlier, also with zero speed.
+	TrackStage GapStage( time_t iGapTime = DEFAULT_GAP_TIME );
+	/// Fills negative speeds with the speed to the next position by the geodesic policy TGeodesic of Geodesy.h,
+	/// a negative speed of the last position with the one before it. The distance cache is filled for gpx::Equirectangular,
+	/// the formula of the cache. Instantiated for the policies of Geodesy.h.
+	template< typename TGeodesic = Equirectangular >
+	TrackStage SpeedStage();
+
+	/// Order, gaps, distances and speeds by TGeodesic.
+	template< typename TGeodesic = Equirectangular >
+	TTrackStages DefaultStages( time_t iGapTime = DEFAULT_GAP_TIME );
+
+	/// Runs @a iStages on @a ioTrack in order.
+	void RunStages( TTrackStages const & iStages, Track & ioTrack );
+}
@@ -0,0 +1,134 @@
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+#include "TrackTail.h"
+#include "Track.h"
+#include "TrackStages.h"
+#include "Profiler.h"
+
+size_t const TAIL_CHUNK_SIZE = 4 << 20; // bytes read from the file at once
+std::string_view const CLOSING_TRACKPT = "</trkpt>";
+
+//-------------------------------------------------------------------------
+TrackTail::TrackTail( std::string iFilePath, float iSpeedLimit, gpx::ReadOptions const & iOptions )
+	: m_filePath( std::move( iFilePath ) )
+	, m_options( iOptions )
+	, m_stages( gpx::WithGeodesic( iOptions.geodesic, [&iOptions]( auto iGeodesic ) {
+		return gpx::DefaultStages< decltype( iGeodesic ) >( iOptions.gapTime );
+	} ) )
+	, m_speedLimit( iSpeedLimit )
+	, m_track( std::make_shared< Track >() )
+{
+	Reset();
+}
+
+//-------------------------------------------------------------------------
+void TrackTail::Reset()
+{
+	m_offset = 0;
+	m_track->clear(); // in place, the track is shared with the readers
+	m_pending.clear();
+	CalculateInfo( 0, 0, m_info );
+}
+
+//-------------------------------------------------------------------------
+bool TrackTail::CalculateInfo( size_t iFirstSegment, size_t iEndSegment, TrackInfo & oInfo ) const
+{
+	return gpx::WithGeodesic( m_options.geodesic, [&]( auto iGeodesic ) {
+		return oInfo.calculate< decltype( iGeodesic ) >( *m_track, m_speedLimit, iFirstSegment, iEndSegment );
+	} );
+}
+
+//-------------------------------------------------------------------------
+size_t TrackTail::Poll()
+{
+	ProfileScope const scope( "TrackTail::Poll" );
+	std::ifstream file( m_filePath.c_str(), std::ios::binary | std::ios::in | std::ios::ate );
+	if( !file )
+		throw std::logic_error( "gpx: Can't open GPX track file: " + m_filePath );
+
+	std::streamoff const fileSize = file.tellg();
+	uint64_t const size = fileSize > 0 ? uint64_t( fileSize ) : 0;
+	size_t firstChanged = m_track->size();
+	if( size < m_offset ) {
+		Reset(); // truncated or replaced
+		firstChanged = 0;
+	}
+
+	// a chunk is parsed up to its last complete element, the rest is read again with the next chunk or by the next Poll()
+	std::string buffer;
+	file.seekg( std::streamoff( m_offset ) );
+	for( uint64_t readTo = m_offset; readTo < size; ) {
+		size_t const kept = buffer.size();
+		buffer.resize( kept + size_t( std::min< uint64_t >( TAIL_CHUNK_SIZE, size - readTo ) ) );
+		file.read( &buffer[ kept ], std::streamsize( buffer.size() - kept ) );
+		size_t const read = size_t( file.gcount() );
+		buffer.resize( kept + read );
+		if( read == 0 )
+			break;
+		readTo += read;
+
+		size_t const end = buffer.rfind( CLOSING_TRACKPT );
+		if( end == std::string::npos )
+			continue;
+		size_t const parsed = end + CLOSING_TRACKPT.size();
+		size_t const pending = m_pending.size();
+		gpx::ReadPositions( std::string_view( buffer ).substr( 0, parsed ), !m_pending.empty() ? m_pending.time.back() : 0, m_options, m_pending );
+		Profiler::Add( Profiler::PositionsRead, m_pending.size() - pending );
+		if( m_pending.size() > pending )
+			Append( firstChanged );
+		m_offset += parsed;
+		buffer.erase( 0, parsed );
+	}
+	return firstChanged;
+}
+
+//-------------------------------------------------------------------------
+void TrackTail::Append( size_t & ioFirstChanged )
+{
+	if( m_pending.size() < 2 )
+		return;
+	Track part = m_pending;
+	gpx::RunStages( m_stages, part );
+
+	size_t const first = m_track->empty() ? 0 : m_track->size() - 1;
+	auto const replaceFrom = [first]( auto & ioColumn, auto const & iPart ) {
+		ioColumn.resize( first );
+		ioColumn.insert( ioColumn.end(), iPart.begin(), iPart.end() );
+	};
+	replaceFrom( m_track->x, part.x );
+	replaceFrom( m_track->y, part.y );
+	replaceFrom( m_track->time, part.time );
+	replaceFrom( m_track->speed, part.speed );
+	if( part.distance.empty() )
+		m_track->distance.clear(); // the cache is not filled by the geodesic of the options
+	else
+		replaceFrom( m_track->distance, part.distance );
+	for( auto const & column: part.extraColumns )
+		replaceFrom( m_track->extraColumns[ column.first ], column.second );
+
+	// only the last position is processed again with the next positions
+	auto const keepLast = []( auto & ioColumn ) { ioColumn.erase( ioColumn.begin(), ioColumn.end() - 1 ); };
+	keepLast( m_pending.x );
+	keepLast( m_pending.y );
+	keepLast( m_pending.time );
+	keepLast( m_pending.speed );
+	for( auto & column: m_pending.extraColumns )
+		keepLast( column.second );
+
+	// segments before the first changed position keep their speeds, so their summary is kept as well
+	TrackInfo added;
+	CalculateInfo( first, m_track->size() - 1, added );
+	m_info.append( added );
+	ioFirstChanged = std::min( ioFirstChanged, first );
+}
+
+//-------------------------------------------------------------------------
+bool TrackTail::SetSpeedLimit( float iSpeedLimit )
+{
+	if( iSpeedLimit == m_speedLimit )
+		return true; // the summary is up to date
+	m_speedLimit = iSpeedLimit;
+	return CalculateInfo( 0, m_track->size() > 0 ? m_track->size() - 1 : 0, m_info );
+}
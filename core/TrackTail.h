@@ -0,0 +1,60 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <time.h>
+#include "MGpxTools.h"
+#include "Track.h"
+#include "TrackInfo.h"
+
+/**
+ * @class TrackTail follows a GPX file while it is being written.
+ *
+ * Poll() parses only the data after the last complete <trkpt> element read before, so a file growing
+ * by appends (or by a rewrite of its closing tags) costs O( new positions ) per call, not O( file ).
+ * New positions get the processing of DefaultStages: the last position of the track gets its real speed
+ * and a pause before the new positions is closed like GapStage does. The track and its TrackInfo grow in place,
+ * both are equal to the ones of reading the whole file with the same options (gpx::Equirectangular distances
+ * within SEGMENT_KERNEL_TOLERANCE: the parts are not split into the SIMD groups of the whole track).
+ *
+ * Only plain GPX files can be followed, compressed ones are read by gpx::ReadTrack.
+ * Not thread safe: Poll() changes the track returned by GetTrack(), readers of it must run on the same thread.
+ */
+class TrackTail
+{
+public:
+	/// Of @a iOptions the gap time, fields, device speed and geodesic are used, so the track is the one
+	/// ReadTrack gives for them. Custom stages, the cache and the simplification are not applied.
+	explicit TrackTail( std::string iFilePath, float iSpeedLimit, gpx::ReadOptions const & iOptions = gpx::ReadOptions() );
+
+	/// Reads what was written since the previous call, throws when the file can't be opened.
+	/// Returns the index of the first position changed or added, GetTrack()->size() when nothing changed.
+	/// A file which became shorter is read again from the start, 0 is returned then.
+	size_t Poll();
+
+	std::shared_ptr< Track const > GetTrack() const { return m_track; }
+	TrackInfo const & Info() const { return m_info; }
+
+	/// Recalculates the summary for another speed limit in O( track ), false when the track has negative speed.
+	bool SetSpeedLimit( float iSpeedLimit );
+
+private:
+	void Reset();
+	void Append( size_t & ioFirstChanged );
+	/// TrackInfo::calculate by the geodesic policy of the options.
+	bool CalculateInfo( size_t iFirstSegment, size_t iEndSegment, TrackInfo & oInfo ) const;
+
+private:
+	std::string const         m_filePath;
+	gpx::ReadOptions const    m_options;
+	gpx::TTrackStages const   m_stages;     /// DefaultStages of the options
+	float                     m_speedLimit;
+	uint64_t                  m_offset = 0; /// bytes of the file up to the end of the last complete <trkpt>
+	std::shared_ptr< Track >  m_track;
+	/// Positions as they are parsed, not processed yet: the last position of the track (its speed depends on the next one)
+	/// and the ones read after it, or a single position read when there is no track yet (a track starts with two).
+	Track                     m_pending;
+	TrackInfo                 m_info;
+};
@@ -0,0 +1,14 @@
+# Links a subproject with the core library, include it after TEMPLATE is set.
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+win32:CONFIG(release, debug|release): GPXCORE_DIR = $$OUT_PWD/../core/release
+else:win32:CONFIG(debug, debug|release): GPXCORE_DIR = $$OUT_PWD/../core/debug
+else: GPXCORE_DIR = $$OUT_PWD/../core
+
+LIBS += -L$$GPXCORE_DIR -lgpxcore -lz
+gpx_zstd: LIBS += -lzstd
+
+win32-g++|!win32: PRE_TARGETDEPS += $$GPXCORE_DIR/libgpxcore.a
+else: PRE_TARGETDEPS += $$GPXCORE_DIR/gpxcore.lib
@@ -0,0 +1,48 @@
+# Qt free static library with GPX parsing and track analysis.
+
+include(../common.pri)
+
+CONFIG -= qt
+CONFIG += staticlib
+
+TARGET = gpxcore
+TEMPLATE = lib
+
+SOURCES += MGpxTools.cpp \
+			Track.cpp \
+			SegmentKernels.cpp \
+			TrackInfo.cpp \
+			SpeedIndex.cpp \
+			SpeedPyramid.cpp \
+			MappedFile.cpp \
+			TrackCache.cpp \
+			IsoTimeDecoder.cpp \
+			ThreadPool.cpp \
+			Profiler.cpp \
+			SpatialIndex.cpp \
+			TrackSimplify.cpp \
+			TrackStages.cpp \
+			TrackRollup.cpp \
+			TrackTail.cpp \
+			CompressedTrack.cpp \
+			CompressedInput.cpp
+
+HEADERS += MGpxTools.h \
+			Track.h \
+			Geodesy.h \
+			SegmentKernels.h \
+			TrackInfo.h \
+			SpeedIndex.h \
+			SpeedPyramid.h \
+			MappedFile.h \
+			TrackCache.h \
+			IsoTimeDecoder.h \
+			ThreadPool.h \
+			Profiler.h \
+			SpatialIndex.h \
+			TrackSimplify.h \
+			TrackStages.h \
+			TrackRollup.h \
+			TrackTail.h \
+			CompressedTrack.h \
+			CompressedInput.h
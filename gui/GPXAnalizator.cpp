@@ -0,0 +1,299 @@
+#include <QLabel>
+#include <QImage>
+#include <QImageWriter>
+#include <QTime>
+#include <QPainter>
+#include <QDebug>
+#include <QTimer>
+#include <QFontMetrics>
+#include <QSettings>
+#include <fstream>
+
+#include "Track.h"
+#include "GPXAnalizator.h"
+#include "Profiler.h"
+#include "ui_mainwindow.h"
+
+GPXAnalizator::GPXAnalizator( QWidget * parent )
+	: QMainWindow( parent )
+	, ui( new Ui::MainWindow )
+	, m_graphWidget( this )
+	, m_cancelLoadButton( tr( "Отмена" ) )
+{
+	ui->setupUi( this );
+	ui->graphlLayout->insertWidget( 0, &m_graphWidget );
+	ui->saveButton->setDisabled( true );
+
+	connect( ui->saveButton, SIGNAL(pressed() ), this, SLOT( saveFile() ) );
+	connect( ui->loadButton, SIGNAL(pressed() ), this, SLOT( openFile() ) );
+
+	m_graphWidget.setScrollBar( ui->horizontalScrollBar );
+	connect( ui->horizontalScrollBar, SIGNAL( valueChanged( int ) ), &m_graphWidget, SLOT( setStartPosition( int ) ) );
+
+	connect( ui->speedLimitEdit, SIGNAL( editingFinished() ), this, SLOT( updateTrackInfo() ) );
+
+	// слежение за файлом, который ещё пишется: дочитываются только дописанные позиции
+	connect( ui->followCheckBox, SIGNAL( toggled( bool ) ), this, SLOT( setFollowing( bool ) ) );
+	connect( &m_fileWatcher, &QFileSystemWatcher::fileChanged, this, &GPXAnalizator::pollTrack );
+
+	// кэш .gpxc пишется рядом с треками пользователя, поэтому только по его выбору; выбор запоминается
+	ui->cacheCheckBox->setChecked( QSettings().value( "cacheTracks", false ).toBool() );
+	connect( ui->cacheCheckBox, &QCheckBox::toggled, this, []( bool checked ) { QSettings().setValue( "cacheTracks", checked ); } );
+
+	// загрузка трека идёт в фоне, ход загрузки и отмена - в строке состояния
+	m_loadProgress.setMaximumWidth( 200 );
+	statusBar()->addPermanentWidget( &m_loadProgress );
+	statusBar()->addPermanentWidget( &m_cancelLoadButton );
+	setLoading( false );
+	connect( &m_cancelLoadButton, SIGNAL( pressed() ), this, SLOT( cancelLoading() ) );
+	connect( &m_trackLoader, &TrackLoader::progress, this, &GPXAnalizator::showLoadProgress );
+	connect( &m_trackLoader, &TrackLoader::loaded, this, &GPXAnalizator::setLoadedTrack );
+
+	// замеры этапов загрузки и отрисовки включаются переменной окружения GPX_ANALIZATOR_TRACE=<файл.json>
+	m_tracePath = QString::fromLocal8Bit( qgetenv( "GPX_ANALIZATOR_TRACE" ) );
+	Profiler::SetEnabled( !m_tracePath.isEmpty() );
+}
+
+void GPXAnalizator::openFile() {
+	QString const fileName = QFileDialog::getOpenFileName( this, tr( "Загрузить GPX файл" ), "", tr( "GPX трек (*.gpx *.gpx.gz *.gpx.zst)" ) );
+	if( !fileName.isEmpty() ) {
+		// загрузка предыдущего файла, если она идёт, отменяется
+		if( ui->followCheckBox->isChecked() )
+			m_trackLoader.follow( fileName, ui->speedLimitEdit->text().toFloat() );
+		else
+			m_trackLoader.load( fileName, ui->cacheCheckBox->isChecked() );
+		setLoading( true );
+		statusBar()->showMessage( "Загрузка файла: " + fileName );
+	}
+}
+
+void GPXAnalizator::cancelLoading() {
+	m_trackLoader.cancel();
+	setLoading( false );
+	statusBar()->showMessage( "Загрузка отменена" );
+}
+
+void GPXAnalizator::showLoadProgress( qint64 bytesRead, qint64 bytesTotal ) {
+	if( bytesTotal > 0 ) {
+		m_loadProgress.setRange( 0, 100 );
+		m_loadProgress.setValue( int( bytesRead * 100 / bytesTotal ) );
+	} else {
+		m_loadProgress.setRange( 0, 0 ); // размер неизвестен
+	}
+}
+
+void GPXAnalizator::setLoadedTrack( std::shared_ptr< LoadedTrack > result ) {
+	if( !m_trackLoader.isCurrent( result->generation ) )
+		return; // пришёл после отмены или начала новой загрузки
+	setLoading( false );
+	if( !result->error.isEmpty() ) {
+		statusBar()->showMessage( "Ошибка загрузки файла: " + result->error );
+		return;
+	}
+
+	if( !m_fileName.isEmpty() )
+		m_fileWatcher.removePath( m_fileName );
+	m_fileName = result->fileName;
+	m_track = std::move( result->track );
+	m_speedIndex = std::move( result->speedIndex );
+	m_trackTail = std::move( result->tail );
+	m_following = m_trackTail && ui->followCheckBox->isChecked(); // флажок могли снять во время загрузки
+	if( m_following )
+		m_fileWatcher.addPath( m_fileName );
+	updateTrackInfo();
+	if( result->notFollowed )
+		statusBar()->showMessage( statusBar()->currentMessage() + " | Сжатый файл загружен целиком, слежение за ним невозможно" );
+	if( m_trackTail || m_speedIndex.IsValid() )
+		m_graphWidget.setTrack( m_track, m_trackInfo.maxSpeed, ui->speedLimitEdit->text().toFloat() );
+	if( !result->profile.isEmpty() ) {
+		statusBar()->showMessage( statusBar()->currentMessage() + " | " + result->profile );
+		writeTrace();
+	}
+}
+
+void GPXAnalizator::setFollowing( bool follow ) {
+	if( m_fileName.isEmpty() || follow == m_following )
+		return;
+	m_following = follow;
+	if( !follow ) {
+		m_fileWatcher.removePath( m_fileName ); // трек остаётся как есть
+		return;
+	}
+	if( m_trackTail ) {
+		m_fileWatcher.addPath( m_fileName );
+		pollTrack(); // дописанное, пока слежение было выключено
+	} else {
+		// трек загружен целиком, для слежения он читается заново через TrackTail
+		m_following = false;
+		m_trackLoader.follow( m_fileName, ui->speedLimitEdit->text().toFloat() );
+		setLoading( true );
+		statusBar()->showMessage( "Загрузка файла: " + m_fileName );
+	}
+}
+
+void GPXAnalizator::pollTrack() {
+	if( !m_following )
+		return;
+	// файл, заменённый переименованием, выпадает из наблюдения
+	if( !m_fileWatcher.files().contains( m_fileName ) )
+		m_fileWatcher.addPath( m_fileName );
+
+	size_t firstChanged = 0;
+	try {
+		firstChanged = m_trackTail->Poll();
+	} catch( std::exception const & e ) {
+		statusBar()->showMessage( "Ошибка чтения файла: " + QString::fromStdString( e.what() ) );
+		return;
+	}
+	if( firstChanged != 0 && firstChanged >= m_track->size() )
+		return; // новых позиций нет
+
+	// сводка и график обновляются по новым позициям, а не по всему треку
+	m_trackInfo = m_trackTail->Info();
+	showTrackInfo();
+	m_graphWidget.updateTrack( m_track, firstChanged, m_trackInfo.maxSpeed );
+}
+
+void GPXAnalizator::writeTrace() const {
+	// после загрузки и при выходе, во втором случае в трассе есть и отрисовка графика
+	std::ofstream trace( m_tracePath.toLocal8Bit().constData() );
+	Profiler::WriteChromeTrace( trace );
+}
+
+void GPXAnalizator::setLoading( bool loading ) {
+	m_loadProgress.setRange( 0, 0 );
+	m_loadProgress.setVisible( loading );
+	m_cancelLoadButton.setVisible( loading );
+}
+
+void GPXAnalizator::saveFile() {
+	QString const fileName = QFileDialog::getSaveFileName( this, tr( "Сохранить файл" ), "", tr( "Картинки (*.png)" ) );
+	if( !fileName.isEmpty() ) {
+		QFile file( fileName );
+		if( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+			statusBar()->showMessage( "Ошибка открытия файла для записи: " + fileName );
+			return;
+		}
+		QImageWriter imgWriter( &file, "png" );
+		QImage const trackInfoImage = makeTrackInfoImage();
+		QSize const graphSize = m_graphWidget.speedImageForSaveSize();
+		QImage resultImage( std::max( graphSize.width(), trackInfoImage.width() ), graphSize.height() + trackInfoImage.height(), QImage::Format_RGB32 );
+		resultImage.fill( Qt::white );
+		QPainter painter( &resultImage );
+		painter.drawImage( 0 , 0, trackInfoImage);
+		painter.end();
+		// график рисуется сразу в итоговую картинку, без промежуточной картинки во весь размер
+		m_graphWidget.drawSpeedImageForSave( resultImage, trackInfoImage.height() );
+		bool const result = imgWriter.write( resultImage );
+		if( result )
+			statusBar()->showMessage( "График скоростей записан в файл: " + fileName );
+		else
+			statusBar()->showMessage( "Ошибка записи картинки: " + imgWriter.errorString() );
+	}
+}
+
+void GPXAnalizator::updateSize() {
+	this->resize( this->width(), this->minimumHeight() );
+}
+
+void GPXAnalizator::updateTrackInfo() {
+	float const speedLimit = ui->speedLimitEdit->text().toFloat();
+	bool valid = false;
+	if( m_trackTail ) {
+		valid = m_trackTail->SetSpeedLimit( speedLimit ); // сводку дописываемого трека ведёт TrackTail
+		m_trackInfo = m_trackTail->Info();
+	} else {
+		valid = m_trackInfo.calculate( m_speedIndex, speedLimit );
+	}
+	if( valid ) {
+		showTrackInfo();
+		m_graphWidget.setSpeedLimit( speedLimit );
+		ui->saveButton->setDisabled( false );
+	} else {
+		statusBar()->showMessage( "Ошибочные данные: отрицательная скорость" );
+		ui->saveButton->setDisabled( true );
+	}
+}
+
+void GPXAnalizator::showTrackInfo() {
+	ui->averageSpeedLabel->setText( "Средняя скорость: " + QString::asprintf( "%.1f", m_trackInfo.averageSpeed) + " км/ч") ;
+	ui->distanceLabel->setText( "Длина пути: " + QString::asprintf("%.1f", m_trackInfo.distance) + " км" );
+	ui->driveDurationLabel->setText( "Вермя в движении: " + GraphWidget::secondsToHumanReadable( m_trackInfo.driveDuration ) );
+	ui->idleDurationLabel->setText( "Время стоянок: " + GraphWidget::secondsToHumanReadable( m_trackInfo.idleDuration ) );
+	ui->idleCountLabel->setText( "Кол-во стоянок: " + QString::asprintf( "%d", m_trackInfo.idleCount ) );
+	ui->maxSpeedLabel->setText( "Максимальная скорость: " + QString::asprintf( "%.1f", m_trackInfo.maxSpeed ) + " км/ч" );
+	ui->minSpeedLabel->setText( "Минимальная скорость: " + QString::asprintf( "%.1f", m_trackInfo.minSpeed ) + " км/ч" );
+	ui->overSpeedCountLabel->setText( "Кол-во превышений скорости: " + QString::asprintf( "%d", m_trackInfo.overSpeedCount ) );
+	ui->overSpeedDurationLabel->setText( "Время с превышением скорости: " + GraphWidget::secondsToHumanReadable( m_trackInfo.overSpeedDuration ) );
+	statusBar()->showMessage( "Считано позиций из файла: " + QString::number( m_track ? m_track->size() : 0 ) );
+}
+
+QImage GPXAnalizator::makeTrackInfoImage() const {
+	int const columnSpace = 30;
+
+	// подготовка информации о треке
+	QStringList trackInfos;
+	trackInfos.push_back( "Кол-во позиций в треке: " + QString::number( m_track ? m_track->size() : 0 ) );
+	trackInfos.push_back( "Средняя скорость: " + QString::asprintf( "%.1f", m_trackInfo.averageSpeed ) + " км/ч");
+	trackInfos.push_back( "Длина пути: " + QString::asprintf( "%.1f", m_trackInfo.distance ) + " км" );
+	trackInfos.push_back( "Вермя в движении: " + GraphWidget::secondsToHumanReadable( m_trackInfo.driveDuration ) );
+	trackInfos.push_back( "Время стоянок: " + GraphWidget::secondsToHumanReadable( m_trackInfo.idleDuration ) );
+	trackInfos.push_back( "Кол-во стоянок: " + QString::asprintf( "%d", m_trackInfo.idleCount ) );
+	trackInfos.push_back( "Максимальная скорость: " + QString::asprintf( "%.1f", m_trackInfo.maxSpeed ) + " км/ч" );
+	trackInfos.push_back( "Минимальная скорость: " + QString::asprintf( "%.1f", m_trackInfo.minSpeed ) + " км/ч" );
+	trackInfos.push_back( "Кол-во превышений скорости: " + QString::asprintf( "%d", m_trackInfo.overSpeedCount ) );
+	trackInfos.push_back( "Время с превышением скорости: " + GraphWidget::secondsToHumanReadable( m_trackInfo.overSpeedDuration ) );
+
+	// расчет требуемых размеров катинки для размещения текста
+	QImage fakeImage( 100, 100, QImage::Format_RGB32 );
+	QPainter fakePainter( &fakeImage );
+	fakePainter.setRenderHint( QPainter::Antialiasing );
+	QFontMetrics fontInfo = fakePainter.fontMetrics();
+	int maxLeftTextWidth = 0;
+	int textHeight = 0;
+	for( int i = 0; i < trackInfos.size() / 2; ++i ) {
+		maxLeftTextWidth = std::max( maxLeftTextWidth, fontInfo.boundingRect( trackInfos[ i ] ).width() );
+		textHeight += fontInfo.boundingRect( trackInfos[ i ] ).height();
+	}
+	int maxRightTextWidth = 0;
+	for( int i = trackInfos.size() / 2; i < trackInfos.size(); ++i ) {
+		maxRightTextWidth = std::max( maxRightTextWidth, fontInfo.boundingRect( trackInfos[ i ] ).width() );
+		textHeight += fontInfo.boundingRect( trackInfos[ i ] ).height();
+	}
+
+
+	int const fontHeight = textHeight / trackInfos.size();
+	QImage result( maxLeftTextWidth + columnSpace * 3 + maxRightTextWidth, textHeight / 2, QImage::Format_RGB32 );
+	result.fill( Qt::white );
+	QPainter painter( &result );
+	painter.setPen( Qt::black );
+	int y = 0;
+	int const leftColumnX = columnSpace / 2;
+	for( int i = 0; i < trackInfos.size() / 2; ++i ) {
+		painter.drawText( leftColumnX, y, trackInfos[ i ] );
+		y += fontHeight;
+	}
+	y = 0;
+	int const rightColumnX = leftColumnX + maxLeftTextWidth + columnSpace;
+	for( int i = trackInfos.size() / 2; i < trackInfos.size(); ++i ) {
+		painter.drawText( rightColumnX, y, trackInfos[ i ] );
+		y += fontHeight;
+	}
+
+	QPen pen( Qt::SolidLine );
+	pen.setWidth( 3 );
+	pen.setColor( Qt::gray );
+	painter.setPen( pen );
+	int const lineX = rightColumnX - columnSpace / 2;
+	painter.drawLine( lineX, fontHeight / 2, lineX, result.height() - fontHeight / 2);
+
+	return result;
+}
+
+GPXAnalizator::~GPXAnalizator()
+{
+	if( Profiler::IsEnabled() )
+		writeTrace();
+	m_graphWidget.setScrollBar( nullptr );
+	delete ui;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <memory>
+#include <QImage>
+#include <QMainWindow>
+#include <QFileDialog>
+#include <QProgressBar>
+#include <QPushButton>
+#include <QFileSystemWatcher>
+#include "GraphWidget.h"
+#include "TrackLoader.h"
+#include "TrackInfo.h"
+#include "SpeedIndex.h"
+#include "TrackTail.h"
+#include "Track.h"
+
+namespace Ui {
+class MainWindow;
+}
+
+class GPXAnalizator : public QMainWindow
+{
+	Q_OBJECT
+
+public:
+	explicit GPXAnalizator( QWidget * parent = 0 );
+	~GPXAnalizator();
+
+public slots:
+	void openFile();
+	void saveFile();
+	void updateSize();
+	void updateTrackInfo();
+	void cancelLoading();
+	void setFollowing( bool follow );
+
+private slots:
+	void showLoadProgress( qint64 bytesRead, qint64 bytesTotal );
+	void setLoadedTrack( std::shared_ptr< LoadedTrack > result );
+	void pollTrack();
+
+private:
+	void setLoading( bool loading );
+	void showTrackInfo();
+	void writeTrace() const;
+
+	QImage makeTrackInfoImage() const;
+
+private:
+	Ui::MainWindow * ui;
+	GraphWidget m_graphWidget;
+	TrackInfo m_trackInfo;
+	std::shared_ptr< Track const > m_track; /// shared with m_graphWidget
+	SpeedIndex m_speedIndex; /// built once per track, makes speed limit changes instant
+	std::shared_ptr< TrackTail > m_trackTail; /// дочитывает m_track при слежении за файлом, тогда m_speedIndex не строится
+	QFileSystemWatcher m_fileWatcher; /// сообщает об изменении m_fileName при слежении
+	QString m_fileName; /// файл текущего трека
+	bool m_following = false; /// изменения m_fileName дочитываются
+	TrackLoader m_trackLoader;
+	QProgressBar m_loadProgress;
+	QPushButton m_cancelLoadButton;
+	QString m_tracePath; /// GPX_ANALIZATOR_TRACE, куда писать Chrome trace, пусто - Profiler выключен
+};
+
@@ -0,0 +1,341 @@
+#include <cmath>
+#include <algorithm>
+#include <QPainter>
+#include <QScrollBar>
+#include <QVBoxLayout>
+#include <QDebug>
+#include "GraphWidget.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+
+int const g_axisWidth = 35;
+int const g_axisLineWidth = 2;
+int const g_tileWidth = 256;
+int const g_bandWidth = 1024; // ширина полосы графика, рисуемой одним потоком при сохранении
+int const g_maxSaveImageWidth = 32000;
+int const g_tileCacheSize = 64 * 1024 * 1024; // байт
+
+GraphWidget::GraphWidget( QWidget * parent )
+	: QWidget( parent )
+	, m_tileCache( g_tileCacheSize )
+{
+	setMinimumHeight( 100 );
+}
+
+void GraphWidget::setTrack( std::shared_ptr< Track const > track, float maxSpeed, float speedLimit ) {
+	m_maxSpeed = maxSpeed;
+	m_speedLimit = speedLimit;
+	m_track = std::move( track );
+	m_tileCache.clear();
+	if ( m_track == nullptr || m_track->size() < 2 ) {
+		m_track.reset();
+		m_speedPyramid.Clear();
+		return;
+	}
+	m_speedPyramid.Build( m_track->speed );
+	if ( m_scrollBar != nullptr )
+		m_scrollBar->setValue( 0 );
+	update();
+}
+
+void GraphWidget::updateTrack( std::shared_ptr< Track const > track, size_t firstChanged, float maxSpeed ) {
+	if( m_track != track || firstChanged == 0 ) {
+		setTrack( std::move( track ), maxSpeed, m_speedLimit );
+		return;
+	}
+	if( firstChanged >= m_track->size() )
+		return;
+
+	ProfileScope const scope( "GraphWidget::updateTrack" );
+	m_speedPyramid.Update( m_track->speed, firstChanged );
+	if( m_maxSpeed != maxSpeed ) {
+		m_maxSpeed = maxSpeed; // масштаб изменился, старые тайлы больше не нужны
+		m_tileCache.clear();
+	} else {
+		// линия к изменённой позиции идёт от предыдущей, пиксель запаса на сглаживание
+		double const changedFrom = double( m_track->time[ firstChanged - 1 ] - m_track->time.front() );
+		for( TileKey const & key: m_tileCache.keys() )
+			if( ( key.index + 1 ) * g_tileWidth + 1 > changedFrom * key.scaleFactor )
+				m_tileCache.remove( key );
+	}
+	// весь трек помещался (максимум 1) или прокручен до конца
+	m_scrollToEnd = m_scrollBar != nullptr && m_scrollBar->value() + 1 >= m_scrollBar->maximum();
+	update();
+}
+
+void GraphWidget::setSpeedLimit( float speedLimit ) {
+	if( m_speedLimit == speedLimit )
+		return;
+	m_speedLimit = speedLimit;
+	m_tileCache.clear();
+	update();
+}
+
+float GraphWidget::saveScaleFactor() const {
+	time_t const duration = m_track->time.back() - m_track->time.front();
+	return ( duration <= g_maxSaveImageWidth ) ? 1 : float( g_maxSaveImageWidth ) / duration;
+}
+
+QSize GraphWidget::speedImageForSaveSize() const {
+	if( m_track == nullptr )
+		return QSize();
+	time_t const duration = m_track->time.back() - m_track->time.front();
+	float const scaleFactor = saveScaleFactor();
+	return QSize( int( duration * scaleFactor ) + g_axisWidth, int( m_maxSpeed * scaleFactor ) + g_axisWidth );
+}
+
+void GraphWidget::drawSpeedImageForSave( QImage & image, int top ) {
+	if( m_track == nullptr )
+		return;
+	ProfileScope const scope( "GraphWidget::drawSpeedImageForSave" );
+	float const scaleFactor = saveScaleFactor();
+	QSize const size = speedImageForSaveSize();
+	int const imageWidth = size.width() - g_axisWidth;
+	int const imageHeight = size.height() - g_axisWidth;
+
+	// каждая полоса - QImage поверх своих столбцов image, полосы не пересекаются, поэтому рисуются одновременно
+	{
+		ThreadPool pool;
+		int const bytesPerPixel = 4; // Format_RGB32
+		for( int bandX = 0; bandX < imageWidth; bandX += g_bandWidth ) {
+			uchar * const bits = image.scanLine( top ) + ( g_axisWidth + bandX ) * bytesPerPixel;
+			int const bandWidth = std::min( g_bandWidth, imageWidth - bandX );
+			auto const bytesPerLine = image.bytesPerLine();
+			pool.Submit( [this, bits, bandX, bandWidth, imageHeight, bytesPerLine, scaleFactor] {
+				ProfileScope const bandScope( "GraphWidget::speedBand" );
+				QImage band( bits, bandWidth, imageHeight, bytesPerLine, QImage::Format_RGB32 );
+				drawSpeedBand( band, bandX / scaleFactor, scaleFactor );
+			} );
+		}
+		pool.Wait();
+	}
+
+	QPainter painter( &image );
+	painter.translate( 0, top );
+	painter.fillRect( 0, 0, g_axisWidth, size.height(), Qt::white );
+	painter.fillRect( g_axisWidth, imageHeight, imageWidth, g_axisWidth, Qt::white );
+	painter.setRenderHint( QPainter::Antialiasing );
+	painter.setClipRect( g_axisWidth, 0, imageWidth, imageHeight );
+	drawSpeedLimitLabel( painter, size.width(), imageHeight, scaleFactor );
+	painter.setClipping( false );
+	drawAxis( painter, size.width(), size.height(), 0, scaleFactor );
+}
+
+QImage GraphWidget::makeSpeedImageForSave() {
+	QImage result( speedImageForSaveSize(), QImage::Format_RGB32 );
+	drawSpeedImageForSave( result, 0 );
+	return result;
+}
+
+void GraphWidget::setStartPosition( int pos ) {
+	m_startPosition = pos;
+	this->update();
+}
+
+void GraphWidget::paintEvent( QPaintEvent * ) {
+	if( m_track == nullptr )
+		return;
+	ProfileScope const scope( "GraphWidget::paintEvent" );
+
+	int const imageWidth = width() - g_axisWidth;
+	int const imageHeight = height() - g_axisWidth;
+	float const scaleFactor =  imageHeight / m_maxSpeed;
+	// адаптируем полосу прокрутки под текущий размер
+	if( m_scrollBar != nullptr ) {
+		time_t const duration = m_track->time.back() - m_track->time.front();
+		if( duration * scaleFactor <= imageWidth ) {
+			m_scrollBar->setMaximum( 1 );
+			m_scrollBar->setMinimum( 0 );
+			m_scrollBar->setPageStep( 1 );
+		} else {
+			int const  pageStep = imageWidth / scaleFactor;
+			int const maximum = duration - pageStep - 1;
+			m_scrollBar->setMaximum( maximum );
+			m_scrollBar->setMinimum( 0 );
+			m_scrollBar->setPageStep( pageStep );
+			m_scrollBar->setSingleStep( std::max( pageStep / 20, 1 ) );
+		}
+		if( m_scrollToEnd ) {
+			m_scrollToEnd = false;
+			m_scrollBar->setValue( m_scrollBar->maximum() ); // меняет m_startPosition через setStartPosition
+		}
+	}
+
+	// график собирается из тайлов фиксированной ширины, при прокрутке рисуются только новые тайлы
+	QPainter painter( this );
+	qint64 const originX = std::llround( double( m_startPosition ) * scaleFactor );
+	painter.setClipRect( g_axisWidth, 0, imageWidth, imageHeight );
+	for( qint64 index = originX / g_tileWidth; index * g_tileWidth < originX + imageWidth; ++index )
+		painter.drawImage( int( g_axisWidth + index * g_tileWidth - originX ), 0, speedTile( index, imageHeight, scaleFactor ) );
+	painter.setClipping( false );
+
+	painter.setRenderHint( QPainter::Antialiasing );
+	drawSpeedLimitLabel( painter, width(), imageHeight, scaleFactor );
+	drawAxis( painter, width(), height(), m_startPosition, scaleFactor );
+}
+
+QString GraphWidget::secondsToHumanReadable( time_t seconds ) {
+	std::vector< int > times;
+	times.reserve( 5 );
+	const auto & rawSeconds = std::div( static_cast< int64_t >( seconds ), static_cast< int64_t >( 60 ) );
+	times.push_back( rawSeconds.rem );
+	const auto & rawMinutes = std::div( rawSeconds.quot, static_cast< int64_t >( 60 ) );
+	times.push_back( rawMinutes.rem );
+	const auto & rawHours = std::div( rawMinutes.quot, static_cast< int64_t >( 24 ) );
+	times.push_back( rawHours.rem );
+	const auto & rawDays = std::div( rawHours.quot, static_cast< int64_t >( 30 ) );
+
+	QString result;
+	if( rawDays.quot > 0 )
+		result = QString::number( rawDays.quot ) + " м." + QString::number( rawDays.rem ) + " д. ";
+	else if( rawDays.rem > 0 )
+		result = QString::number( rawDays.rem ) + " д. ";
+
+	for( int i = times.size() - 1; i >= 0; --i )
+		if( times[ i ] > 0 || !result.isEmpty() )
+			result += QString::asprintf( "%02d:", times[ i ] );
+	result.resize( result.size() - 1 ); // удаляем последний лишний символ ':'
+	return result;
+}
+
+void GraphWidget::drawAxis( QPainter & painter, float painterWidth, float painterHeight, int startOffset, float scaleFactor ) {
+	QPen axisPen( Qt::SolidLine );
+	axisPen.setWidth( g_axisLineWidth );
+	axisPen.setColor( Qt::black );
+	painter.setPen( axisPen );
+
+	// рисуем оси
+	int const axisDrawWidth = g_axisWidth - g_axisLineWidth;
+	painter.drawLine( axisDrawWidth, 0, axisDrawWidth, painterHeight - axisDrawWidth );
+	painter.drawLine( axisDrawWidth, painterHeight - axisDrawWidth, painterWidth, painterHeight - axisDrawWidth );
+
+	// рисуем стрелки на осях
+	painter.drawLine( axisDrawWidth, g_axisLineWidth, axisDrawWidth - g_axisLineWidth, g_axisLineWidth * 4 );
+	painter.drawLine( axisDrawWidth, g_axisLineWidth, axisDrawWidth + g_axisLineWidth, g_axisLineWidth * 4 );
+	painter.drawLine( painterWidth - g_axisLineWidth, painterHeight - axisDrawWidth, painterWidth - g_axisLineWidth * 4, painterHeight - axisDrawWidth - g_axisLineWidth );
+	painter.drawLine( painterWidth - g_axisLineWidth, painterHeight - axisDrawWidth, painterWidth - g_axisLineWidth * 4, painterHeight - axisDrawWidth + g_axisLineWidth );
+
+	// размечаем Y ось координатами
+	QFontMetrics fontInfo = painter.fontMetrics();
+	const float YlabelHeight = fontInfo.boundingRect( "0" ).height();
+	const float rawYLabelsCount = painterHeight / 3 / YlabelHeight;
+	const float rawYDelimeter = m_maxSpeed / rawYLabelsCount;
+	const std::vector< int > yDelimeters = { 1, 5, 10, 20, 50, 100, 200, 300, 400, 500, 1000 };
+	const auto YDelimIter = std::upper_bound( yDelimeters.begin(), yDelimeters.end(), int( rawYDelimeter ) );
+	const int YDelimeter = YDelimIter != yDelimeters.end() ? *YDelimIter : yDelimeters.back();
+	for( int i = 0; i * YDelimeter < m_maxSpeed; ++i ) {
+		int const YLabelValue = i * YDelimeter;
+		QString const YLabel = QString::number( YLabelValue ) + "  ";
+		const float YLabelX = axisDrawWidth - g_axisLineWidth * 2 - fontInfo.boundingRect( YLabel ).width();
+		const float lineY = painterHeight - axisDrawWidth - YLabelValue * scaleFactor;
+		const float YLabelY = lineY + fontInfo.boundingRect( YLabel ).height() / 2.0;
+		painter.drawText( YLabelX, YLabelY, YLabel );
+		painter.drawLine( axisDrawWidth, lineY, axisDrawWidth - g_axisLineWidth * 2, lineY );
+	}
+
+	// размечаем X ось координатами
+	const float XlabelWidth = fontInfo.boundingRect( secondsToHumanReadable( startOffset + painterWidth / scaleFactor ) ).width();
+	const float rawXLabelsCount = painterWidth / 2 / XlabelWidth;
+	const float rawXDelimeter = (painterWidth / scaleFactor) / rawXLabelsCount;
+	const std::vector< int > xDelimeters = { 1, 5, 10, 20, 30, 60, 120, 180, 300, 600, 1800, 3600, 18000 };
+	const auto XDelimIter = std::upper_bound( xDelimeters.begin(), xDelimeters.end(), int( rawXDelimeter ) );
+	const int XDelimeter = XDelimIter != xDelimeters.end() ? *XDelimIter : xDelimeters.back();
+	for( int i = startOffset / XDelimeter; i * XDelimeter * scaleFactor < ( startOffset * scaleFactor + painterWidth ); ++i ) {
+		int const XLabelValue = i * XDelimeter;
+		QString const XLabel = secondsToHumanReadable( XLabelValue );
+		const float axisLineX = ( XLabelValue - startOffset ) * scaleFactor;
+		if( axisLineX < 0 )
+			continue;
+		const float lineX = axisLineX + axisDrawWidth;
+
+		painter.drawLine( lineX, painterHeight - axisDrawWidth, lineX, painterHeight - axisDrawWidth - g_axisLineWidth * 2 );
+
+		const float XLabelX = lineX - fontInfo.boundingRect( XLabel ).width() / 2.0;
+		painter.drawText( XLabelX, painterHeight, XLabel );
+	}
+}
+
+QImage GraphWidget::speedTile( qint64 index, int imageHeight, float scaleFactor ) {
+	TileKey const key = { index, scaleFactor, m_speedLimit, imageHeight };
+	if( QImage const * cached = m_tileCache.object( key ) )
+		return *cached;
+
+	ProfileScope const scope( "GraphWidget::speedTile" );
+	QImage tile( g_tileWidth, imageHeight, QImage::Format_RGB32 );
+	drawSpeedBand( tile, double( index ) * g_tileWidth / scaleFactor, scaleFactor );
+
+	// QCache владеет своей копией и может сразу удалить её, поэтому возвращаем tile (данные общие, копирования нет)
+	m_tileCache.insert( key, new QImage( tile ), tile.bytesPerLine() * tile.height() );
+	return tile;
+}
+
+void GraphWidget::drawSpeedBand( QImage & band, double startOffset, float scaleFactor ) const {
+	// полоса графика без подписей: тайл при прокрутке или часть сохраняемой картинки, может рисоваться не в GUI потоке
+	band.fill( Qt::white );
+	QPainter bandPainter( &band );
+	bandPainter.setRenderHint( QPainter::Antialiasing );
+	drawSpeedLimitLine( bandPainter, band.width(), band.height(), scaleFactor );
+	bandPainter.setPen( Qt::blue );
+	drawSpeedGraph( bandPainter, band.width(), band.height(), startOffset, scaleFactor );
+}
+
+void GraphWidget::drawSpeedLimitLine( QPainter & painter, float imageWidth, float imageHeight, float scaleFactor ) const {
+	// рисуем линию ограничения скорости
+	painter.setPen( Qt::red );
+	float const speedLimitY = imageHeight - m_speedLimit * scaleFactor;
+	painter.drawLine( 0, speedLimitY, imageWidth, speedLimitY );
+}
+
+void GraphWidget::drawSpeedLimitLabel( QPainter & painter, float imageRight, float imageHeight, float scaleFactor ) const {
+	// подпись рисуется поверх тайлов у правого края изображения
+	painter.setPen( Qt::red );
+	float const speedLimitY = imageHeight - m_speedLimit * scaleFactor;
+	QFontMetrics fontInfo = painter.fontMetrics();
+	QString const label = QString::number( m_speedLimit ) + " км/ч";
+	int const labelWidth = fontInfo.boundingRect( label ).width();
+	int const labelHeight = fontInfo.boundingRect( label ).height();
+	painter.drawText( imageRight - labelWidth, speedLimitY - labelHeight / 3.0, label );
+}
+
+void GraphWidget::drawSpeedGraph( QPainter & painter, float imageWidth, float imageHeight, double startOffset, float scaleFactor ) const {
+	// Рисуем только позиции под изображением. Если в столбец пикселей попадает больше двух позиций,
+	// вместо отдельных линий рисуем один вертикальный отрезок от минимальной до максимальной скорости (из m_speedPyramid).
+	std::vector< time_t > const & times = m_track->time;
+	std::vector< double > const & speeds = m_track->speed;
+	time_t const startTime = times.front();
+	auto const pointAt = [&]( size_t i ) {
+		return QPointF( ( times[ i ] - startTime - startOffset ) * scaleFactor, imageHeight - speeds[ i ] * scaleFactor );
+	};
+	auto const isBefore = []( time_t iTime, double iBorder ) { return iTime < iBorder; };
+
+	double const visibleStart = double( startTime ) + startOffset;
+	double const visibleEnd = visibleStart + imageWidth / scaleFactor;
+	size_t first = std::lower_bound( times.begin(), times.end(), visibleStart, isBefore ) - times.begin();
+	size_t const last = std::min( size_t( std::lower_bound( times.begin(), times.end(), visibleEnd, isBefore ) - times.begin() ) + 1, times.size() );
+
+	QPointF fromPoint( 0, imageHeight );
+	if( first > 0 )
+		fromPoint = pointAt( first - 1 ); // линия, входящая в изображение слева
+
+	for( size_t i = first; i < last; ) {
+		double const column = std::floor( pointAt( i ).x() );
+		double const columnEnd = visibleStart + ( column + 1 ) / scaleFactor;
+		size_t const next = std::max( size_t( std::lower_bound( times.begin() + i, times.begin() + last, columnEnd, isBefore ) - times.begin() ), i + 1 );
+		if( next - i <= 2 ) {
+			for( ; i < next; ++i ) {
+				QPointF toPoint = pointAt( i );
+				painter.drawLine( fromPoint, toPoint );
+				fromPoint = std::move( toPoint );
+			}
+			continue;
+		}
+
+		double minSpeed, maxSpeed;
+		m_speedPyramid.Range( speeds, i, next, minSpeed, maxSpeed );
+		painter.drawLine( fromPoint, pointAt( i ) );
+		double const columnX = column + 0.5;
+		painter.drawLine( QPointF( columnX, imageHeight - maxSpeed * scaleFactor ), QPointF( columnX, imageHeight - minSpeed * scaleFactor ) );
+		fromPoint = pointAt( next - 1 );
+		i = next;
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+#include <QWidget>
+#include <QCache>
+#include <QImage>
+#include "Track.h"
+#include "SpeedPyramid.h"
+
+class QPainter;
+class QScrollBar;
+
+class GraphWidget : public QWidget
+{
+	Q_OBJECT
+public:
+	explicit GraphWidget( QWidget * parent = 0 );
+
+	void setTrack( std::shared_ptr< Track const > track, float maxSpeed, float speedLimit );
+	/// Трек дописан на месте (см. TrackTail::Poll): позиции начиная с firstChanged изменены или добавлены.
+	/// Пирамида скоростей достраивается, из кэша удаляются только тайлы с изменёнными позициями.
+	void updateTrack( std::shared_ptr< Track const > track, size_t firstChanged, float maxSpeed );
+	void setSpeedLimit( float speedLimit );
+
+	void setScrollBar( QScrollBar * scrollBar ) {
+		m_scrollBar = scrollBar;
+	}
+
+	/// Размер картинки графика для сохранения вместе с осями.
+	QSize speedImageForSaveSize() const;
+	/// Рисует картинку графика для сохранения в image (Format_RGB32) начиная со строки top.
+	/// Вертикальные полосы графика рисуются параллельно прямо в image, без промежуточных картинок.
+	void drawSpeedImageForSave( QImage & image, int top );
+	QImage makeSpeedImageForSave();
+
+	static QString secondsToHumanReadable( time_t seconds );
+
+signals:
+
+public slots:
+	void setStartPosition( int pos );
+
+protected:
+	void paintEvent( QPaintEvent * );
+
+private:
+	/// Ключ тайла графика: тайл index занимает пиксели [ index * ширина тайла, ( index + 1 ) * ширина тайла ) от начала трека.
+	struct TileKey {
+		qint64 index;
+		float scaleFactor;
+		float speedLimit;
+		int height;
+
+		bool operator==( TileKey const & other ) const {
+			return index == other.index && scaleFactor == other.scaleFactor && speedLimit == other.speedLimit && height == other.height;
+		}
+		friend uint qHash( TileKey const & key, uint seed = 0 ) {
+			return qHash( key.index, seed ) ^ qHash( key.scaleFactor, seed ) ^ qHash( key.speedLimit, seed ) ^ qHash( key.height, seed );
+		}
+	};
+
+	void drawAxis( QPainter & painter, float painterWidth, float painterHeight, int startOffset, float scaleFactor );
+	float saveScaleFactor() const;
+	QImage speedTile( qint64 index, int imageHeight, float scaleFactor );
+	void drawSpeedBand( QImage & band, double startOffset, float scaleFactor ) const;
+	void drawSpeedLimitLine( QPainter & painter, float imageWidth, float imageHeight, float scaleFactor ) const;
+	void drawSpeedLimitLabel( QPainter & painter, float imageRight, float imageHeight, float scaleFactor ) const;
+	void drawSpeedGraph( QPainter & painter, float imageWidth, float imageHeight, double startOffset, float scaleFactor ) const;
+
+private:
+	QCache< TileKey, QImage > m_tileCache; /// отрисованные тайлы графика, стоимость - размер в байтах
+	std::shared_ptr< Track const > m_track; /// общий с GPXAnalizator, пустой, если трека нет
+	SpeedPyramid m_speedPyramid; /// min/max of speed for ranges of positions, built in setTrack
+	float m_maxSpeed = 0;
+	float m_speedLimit = 105;
+	int m_startPosition = 0;
+	bool m_scrollToEnd = false; /// трек дописан, когда был виден его конец: показать новый конец при отрисовке
+	QScrollBar * m_scrollBar = nullptr;
+};
@@ -0,0 +1,104 @@
+#include <exception>
+#include "MGpxTools.h"
+#include "Profiler.h"
+#include "CompressedInput.h"
+#include "TrackLoader.h"
+
+TrackLoader::TrackLoader( QObject * parent )
+	: QObject( parent )
+{
+	qRegisterMetaType< std::shared_ptr< LoadedTrack > >();
+	m_worker.moveToThread( &m_thread );
+	m_thread.start();
+}
+
+TrackLoader::~TrackLoader() {
+	cancel();
+	m_thread.quit();
+	m_thread.wait();
+}
+
+void TrackLoader::load( QString const & fileName, bool useCache ) {
+	quint64 const generation = ++m_generation;
+	QMetaObject::invokeMethod( &m_worker, [this, fileName, generation, useCache] { run( fileName, generation, useCache ); }, Qt::QueuedConnection );
+}
+
+void TrackLoader::follow( QString const & fileName, float speedLimit ) {
+	quint64 const generation = ++m_generation;
+	QMetaObject::invokeMethod( &m_worker, [this, fileName, generation, speedLimit] { runFollow( fileName, generation, speedLimit ); }, Qt::QueuedConnection );
+}
+
+void TrackLoader::cancel() {
+	++m_generation;
+}
+
+void TrackLoader::run( QString fileName, quint64 generation, bool useCache ) {
+	if( !isCurrent( generation ) )
+		return; // отменена, пока ждала в очереди
+
+	if( Profiler::IsEnabled() )
+		Profiler::Reset(); // в сводке только эта загрузка
+	auto result = std::make_shared< LoadedTrack >();
+	result->generation = generation;
+	result->fileName = fileName;
+	if( read( *result, useCache ) )
+		finish( std::move( result ) );
+}
+
+bool TrackLoader::read( LoadedTrack & result, bool useCache ) {
+	quint64 const generation = result.generation;
+	gpx::ReadOptions options;
+	options.useCache = useCache;
+	options.isCancelled = [this, generation] { return !isCurrent( generation ); };
+	options.progress = [this, generation]( size_t bytesRead, size_t bytesTotal ) {
+		if( isCurrent( generation ) )
+			emit progress( qint64( bytesRead ), qint64( bytesTotal ) );
+	};
+	try {
+		auto track = std::make_shared< Track >( gpx::ReadTrack( result.fileName.toStdString(), options ) );
+		if( !isCurrent( generation ) )
+			return false;
+		result.speedIndex = SpeedIndex( *track );
+		result.track = std::move( track );
+	} catch( gpx::ReadCancelled const & ) {
+		return false;
+	} catch( std::exception const & e ) {
+		result.error = QString::fromStdString( e.what() );
+	}
+	return true;
+}
+
+void TrackLoader::runFollow( QString fileName, quint64 generation, float speedLimit ) {
+	if( !isCurrent( generation ) )
+		return;
+
+	if( Profiler::IsEnabled() )
+		Profiler::Reset();
+	auto result = std::make_shared< LoadedTrack >();
+	result->generation = generation;
+	result->fileName = fileName;
+	if( CompressedInput::Detect( fileName.toStdString() ) != CompressedInput::ECompression::None ) {
+		// TrackTail дочитывает только несжатый текст
+		result->notFollowed = true;
+		if( read( *result, false ) )
+			finish( std::move( result ) );
+		return;
+	}
+	try {
+		// кэш не используется: файл меняется
+		auto tail = std::make_shared< TrackTail >( fileName.toStdString(), speedLimit );
+		tail->Poll();
+		result->track = tail->GetTrack();
+		result->tail = std::move( tail );
+	} catch( std::exception const & e ) {
+		result->error = QString::fromStdString( e.what() );
+	}
+	finish( std::move( result ) );
+}
+
+void TrackLoader::finish( std::shared_ptr< LoadedTrack > result ) {
+	if( Profiler::IsEnabled() )
+		result->profile = QString::fromStdString( Profiler::Summary() );
+	if( isCurrent( result->generation ) )
+		emit loaded( result );
+}
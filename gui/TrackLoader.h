@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include "Track.h"
+#include "SpeedIndex.h"
+#include "TrackTail.h"
+
+/// Результат загрузки трека, передаётся из потока загрузки через shared_ptr, поэтому трек не копируется.
+struct LoadedTrack
+{
+	quint64 generation = 0; /// номер загрузки, см. TrackLoader::isCurrent
+	QString fileName;
+	std::shared_ptr< Track const > track;
+	SpeedIndex speedIndex; /// не строится при слежении за файлом
+	std::shared_ptr< TrackTail > tail; /// дочитывает трек при слежении за файлом, track - его трек
+	bool notFollowed = false; /// слежение запрошено, но файл сжат: он прочитан целиком, tail нет
+	QString error; /// пусто, если файл прочитан
+	QString profile; /// сводка Profiler по загрузке, пусто, если он выключен
+};
+
+Q_DECLARE_METATYPE( std::shared_ptr< LoadedTrack > )
+
+/// Читает трек и строит SpeedIndex в отдельном потоке. Новая загрузка отменяет текущую.
+class TrackLoader : public QObject
+{
+	Q_OBJECT
+public:
+	explicit TrackLoader( QObject * parent = 0 );
+	~TrackLoader();
+
+	/// Начинает загрузку файла, вызывается из потока GUI.
+	/// useCache - читать и писать кэш .gpxc рядом с файлом, см. TrackCache.h.
+	void load( QString const & fileName, bool useCache );
+	/// Начинает загрузку файла, который ещё пишется: трек читается через TrackTail со сводкой для speedLimit,
+	/// дальше он дочитывается в потоке GUI. Первое чтение не отменяется и не сообщает о ходе.
+	/// Сжатый файл дочитывать нельзя, он загружается как load() без кэша.
+	void follow( QString const & fileName, float speedLimit );
+	/// Отменяет текущую загрузку, её результат не будет отправлен.
+	void cancel();
+	/// Результат загрузки ещё актуален: после неё не было load() и cancel().
+	bool isCurrent( quint64 generation ) const {
+		return generation == m_generation.load();
+	}
+
+signals:
+	/// Отправляются из потока загрузки.
+	void progress( qint64 bytesRead, qint64 bytesTotal );
+	void loaded( std::shared_ptr< LoadedTrack > result );
+
+private:
+	void run( QString fileName, quint64 generation, bool useCache );
+	void runFollow( QString fileName, quint64 generation, float speedLimit );
+	/// Читает весь файл в result, false - загрузка отменена.
+	bool read( LoadedTrack & result, bool useCache );
+	void finish( std::shared_ptr< LoadedTrack > result );
+
+private:
+	std::atomic< quint64 > m_generation { 0 };
+	QThread m_thread;
+	QObject m_worker; /// живёт в m_thread, через него загрузки ставятся в очередь потока
+};
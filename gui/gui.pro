@@ -0,0 +1,27 @@
+#-------------------------------------------------
+#
+# Project created by QtCreator 2017-05-10T22:26:42
+#
+#-------------------------------------------------
+
+include(../common.pri)
+
+QT       += core gui
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+TARGET = GPX_Analizator
+TEMPLATE = app
+
+include(../core/core.pri)
+
+SOURCES += main.cpp\
+			GraphWidget.cpp \
+    GPXAnalizator.cpp \
+    TrackLoader.cpp
+
+HEADERS  += GraphWidget.h \
+    GPXAnalizator.h \
+    TrackLoader.h
+
+FORMS    += mainwindow.ui
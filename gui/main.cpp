@@ -4,6 +4,8 @@
 int main(int argc, char *argv[])
 {
 	QApplication a(argc, argv);
+	a.setOrganizationName( "GPX_Analizator" ); // для QSettings
+	a.setApplicationName( "GPX_Analizator" );
 	GPXAnalizator gpxAnalizator;
 	gpxAnalizator.show();
 